@@ -0,0 +1,708 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T09:12:40+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: benchmarks.cpp
+ * @Last modified time: 2026-10-19T09:12:40+02:00
+ */
+
+#include <cmath>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <ctime>
+
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+//the benchmarks drive the private update functions directly, like the tests
+#define private public
+
+#include "position_library.h"
+#include "fleet_index.h"
+#include "pose_checkpoint.h"
+#include "pose_smoother.h"
+#include "trajectory_compression.h"
+#include "fixed_point.h"
+#include "event_loop.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the number of carts of the fleet benchmarks
+#define BENCH_FLEET_CARTS          10000
+//the side of the square warehouse in meters
+#define BENCH_FLEET_AREA_M         500.0
+//the number of fleet updates or queries timed
+#define BENCH_FLEET_ITERATIONS     200000
+//the number of checkpoints written or restored
+#define BENCH_CHECKPOINT_ITERATIONS 200
+//the checkpoint file of the benchmarks
+#define BENCH_CHECKPOINT_FILE      "build/benchmarks.ckpt"
+//the sample rate of the smoother input in Hz
+#define BENCH_SMOOTHER_RATE_HZ     4000
+//the number of samples smoothed, one minute at 4kHz
+#define BENCH_SMOOTHER_SAMPLES     240000
+//the number of poses compressed, one hour at 100Hz
+#define BENCH_COMPRESSION_POSES    360000
+//the time the parked robot loops run, in miliseconds
+#define BENCH_PARKED_MS            3000
+//the number of pose updates timed for the float and fixed point paths
+#define BENCH_UPDATE_ITERATIONS    4000000
+//the number of distinct samples the updates cycle through
+#define BENCH_UPDATE_SAMPLES       4096
+//the number of gyrometer samples of the batch benchmarks, odometry has half
+#define BENCH_BATCH_SAMPLES        1000000
+//the duration of the drive of the integration benchmarks in seconds
+#define BENCH_DRIVE_S              60
+//the step of the reference integration in seconds
+#define BENCH_DRIVE_STEP_S         0.0001
+//the time the acquisition benchmarks run, in miliseconds
+#define BENCH_ACQUISITION_MS       2000
+//the frequency of every acquisition source in Hz
+#define BENCH_ACQUISITION_HZ       1000
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////helpers//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: nowNs
+//~ ----------------------------
+//~ output: double; a monotonic time in nanoseconds
+static double nowNs(void){
+  using std::chrono::steady_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  return duration_cast<nanoseconds>(
+    steady_clock::now().time_since_epoch()).count();
+}// end function nowNs
+
+//~ Function: report
+//~ ----------------------------
+//~ Prints the time per operation of a benchmark
+//~
+//~ input: const char *name; the benchmark name, double elapsedNs; the total
+//~   time, long operations; the number of operations timed
+//~
+//~ output: void
+static void report(const char *name, double elapsedNs, long operations){
+  std::printf("%-40s %10.1f ns/op %12.0f op/s\n", name,
+    elapsedNs/operations, operations/(elapsedNs*1e-9));
+}// end function report
+
+//~ Function: cpuNs
+//~ ----------------------------
+//~ output: double; the cpu time used by the process in nanoseconds
+static double cpuNs(void){
+  struct timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return now.tv_sec*1e9 + now.tv_nsec;
+}// end function cpuNs
+
+//~ Function: cycles
+//~ ----------------------------
+//~ output: uint64_t; the time stamp counter on x86, 0 elsewhere
+static uint64_t cycles(void){
+#ifdef __x86_64__
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}// end function cycles
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+/////////////////////////////benchmarks/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: benchFleet
+//~ ----------------------------
+//~ Times the pose updates and the proximity queries of a fleet of carts
+//~   driving in a warehouse
+//~
+//~ output: void
+static void benchFleet(void){
+  fleetPoses fleet_poses;
+  std::vector<std::array<float, COORDS_SIZE>> poses(BENCH_FLEET_CARTS);
+  std::vector<uint32_t> cartIds;
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> position(0, BENCH_FLEET_AREA_M);
+  std::uniform_real_distribution<float> heading(-PI, PI);
+  size_t found = 0;
+
+  for (uint32_t id = 0; id < BENCH_FLEET_CARTS; id++){
+    poses[id] = {position(generator), position(generator), heading(generator)};
+    fleet_poses.updatePose(id, poses[id]);
+  }
+
+  //every cart moves of 1.5cm, a 100Hz update at 1.5m/s
+  double start = nowNs();
+  for (long i = 0; i < BENCH_FLEET_ITERATIONS; i++){
+    uint32_t id = i % BENCH_FLEET_CARTS;
+    poses[id][0] += 0.015*cos(poses[id][2]);
+    poses[id][1] += 0.015*sin(poses[id][2]);
+    fleet_poses.updatePose(id, poses[id]);
+  }
+  report("fleet updatePose (10k carts)", nowNs() - start,
+    BENCH_FLEET_ITERATIONS);
+
+  start = nowNs();
+  for (long i = 0; i < BENCH_FLEET_ITERATIONS; i++){
+    uint32_t id = i % BENCH_FLEET_CARTS;
+    found += fleet_poses.radiusQuery({poses[id][0], poses[id][1]}, 2,
+      cartIds);
+  }
+  report("fleet radiusQuery 2m (10k carts)", nowNs() - start,
+    BENCH_FLEET_ITERATIONS);
+
+  start = nowNs();
+  for (long i = 0; i < BENCH_FLEET_ITERATIONS; i++){
+    uint32_t id = i % BENCH_FLEET_CARTS;
+    found += fleet_poses.kNearest({poses[id][0], poses[id][1]}, 8, cartIds);
+  }
+  report("fleet kNearest k=8 (10k carts)", nowNs() - start,
+    BENCH_FLEET_ITERATIONS);
+
+  start = nowNs();
+  for (long i = 0; i < BENCH_FLEET_ITERATIONS; i++){
+    float x = (i*37) % (int) BENCH_FLEET_AREA_M;
+    found += fleet_poses.zoneQuery({x, x}, {x + 10, x + 10}, cartIds);
+  }
+  report("fleet zoneQuery 10x10m (10k carts)", nowNs() - start,
+    BENCH_FLEET_ITERATIONS);
+
+  std::printf("(%zu carts found)\n", found);
+}// end function benchFleet
+
+//~ Function: benchCheckpoint
+//~ ----------------------------
+//~ Times a checkpoint write and a warm restart, that is opening the file and
+//~   restoring the latest checkpoint
+//~
+//~ output: void
+static void benchCheckpoint(void){
+  poseCheckpoint checkpoint;
+  robotPosition robot_position;
+  robotState state = {{1, 2, 0.5}, 1000, 1000};
+
+  if (checkpoint.openFile(BENCH_CHECKPOINT_FILE) < 0){
+    std::printf("checkpoint: cannot open %s\n", BENCH_CHECKPOINT_FILE);
+    return;
+  }
+
+  double start = nowNs();
+  for (long i = 0; i < BENCH_CHECKPOINT_ITERATIONS; i++){
+    state.lastXYUpdateMS++;
+    checkpoint.writeState(state);
+  }
+  report("checkpoint writeState (fdatasync)", nowNs() - start,
+    BENCH_CHECKPOINT_ITERATIONS);
+
+  start = nowNs();
+  for (long i = 0; i < BENCH_CHECKPOINT_ITERATIONS; i++){
+    poseCheckpoint restarted;
+    restarted.openFile(BENCH_CHECKPOINT_FILE);
+    restarted.readLatest(state);
+    robot_position.restoreState(state);
+  }
+  report("checkpoint warm restart", nowNs() - start,
+    BENCH_CHECKPOINT_ITERATIONS);
+  remove(BENCH_CHECKPOINT_FILE);
+}// end function benchCheckpoint
+
+//~ Function: benchSmoother
+//~ ----------------------------
+//~ Times the fixed-lag smoother at 4kHz with and without absolute fixes,
+//~   solving the whole window at every sample. With fixes a fix is always in
+//~   the window, so every sample also refactorizes
+//~
+//~ input: size_t windowSize; the number of poses in the window,
+//~   int fixPeriod; the number of samples between two fixes, 0 for none
+//~
+//~ output: void
+static void benchSmoother(size_t windowSize, int fixPeriod){
+  poseSmoother pose_smoother(windowSize);
+  std::array<float, COORDS_SIZE> pose;
+  char name[64];
+
+  double start = nowNs();
+  for (long i = 1; i <= BENCH_SMOOTHER_SAMPLES; i++){
+    pose_smoother.addSample(0.0004, 0.0001);
+    if (fixPeriod > 0 && i % fixPeriod == 0){
+      pose_smoother.addFix({(float) (i*0.0004), 0, 0});
+    }
+    pose_smoother.solve();
+  }
+  double elapsed = nowNs() - start;
+  pose_smoother.getPose(windowSize/2, pose);
+
+  std::snprintf(name, sizeof(name), "smoother window %zu fix/%d", windowSize,
+    fixPeriod);
+  report(name, elapsed, BENCH_SMOOTHER_SAMPLES);
+  std::printf("  %.1fx real time at %dHz, %llu factorizations\n",
+    BENCH_SMOOTHER_SAMPLES*1e9/BENCH_SMOOTHER_RATE_HZ/elapsed,
+    BENCH_SMOOTHER_RATE_HZ,
+    (unsigned long long) pose_smoother.factorizations());
+}// end function benchSmoother
+
+//~ Function: syntheticTrajectory
+//~ ----------------------------
+//~ Generates a cart mission at 100Hz: straight lines, turns and stops
+//~
+//~ inout: std::vector<trajectoryPoint> &poses; the returned trajectory
+//~
+//~ output: void
+static void syntheticTrajectory(std::vector<trajectoryPoint> &poses){
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<int> segmentLength(100, 1500);
+  std::uniform_real_distribution<float> turnRate(-0.8, 0.8);
+  std::array<float, COORDS_SIZE> pose = {0, 0, 0};
+  float speed = 0;
+  float yawRate = 0;
+  int remaining = 0;
+
+  for (uint32_t i = 0; i < BENCH_COMPRESSION_POSES; i++){
+    //pick the next segment: a stop, a straight line or a turn
+    if (remaining-- <= 0){
+      remaining = segmentLength(generator);
+      int kind = remaining % 3;
+      speed = kind == 0 ? 0 : 1.2;
+      yawRate = kind == 2 ? turnRate(generator) : 0;
+    }
+    pose[2] = fmod(pose[2] + yawRate*0.01, 2*PI);
+    pose[0] += speed*0.01*cos(pose[2]);
+    pose[1] += speed*0.01*sin(pose[2]);
+    poses.push_back({i*10, pose});
+  }
+}// end function syntheticTrajectory
+
+//~ Function: replayedTrajectory
+//~ ----------------------------
+//~ Replays noisy gyrometer and odometry samples of the same kind of mission
+//~   through robotPosition and records its pose output at 100Hz
+//~
+//~ inout: std::vector<trajectoryPoint> &poses; the returned trajectory
+//~
+//~ output: void
+static void replayedTrajectory(std::vector<trajectoryPoint> &poses){
+  robotPosition robot_position;
+  std::mt19937 generator(11);
+  std::normal_distribution<float> gyroNoise(0, 0.02);
+  std::normal_distribution<float> wheelNoise(0, 0.0005);
+  std::uniform_int_distribution<int> segmentLength(100, 1500);
+  std::uniform_real_distribution<float> turnRate(-0.8, 0.8);
+  float speed = 0;
+  float yawRate = 0;
+  int remaining = 0;
+
+  for (uint32_t i = 0; i < BENCH_COMPRESSION_POSES; i++){
+    if (remaining-- <= 0){
+      remaining = segmentLength(generator);
+      int kind = remaining % 3;
+      speed = kind == 0 ? 0 : 1.2;
+      yawRate = kind == 2 ? turnRate(generator) : 0;
+    }
+    float left = speed*0.01 + wheelNoise(generator);
+    float right = speed*0.01 + wheelNoise(generator);
+    robot_position.updateCoords({left, right, left, right}, 10,
+      yawRate + gyroNoise(generator), 10);
+    poses.push_back({i*10, robot_position.coords});
+  }
+}// end function replayedTrajectory
+
+//~ Function: benchCompression
+//~ ----------------------------
+//~ Times the compression of a trajectory and reports the compression ratio
+//~   against 16 bytes per raw pose
+//~
+//~ input: const char *name; the trajectory name,
+//~   const std::vector<trajectoryPoint> &poses; the trajectory,
+//~   float maxXYError, float maxTethaError; the allowed errors
+//~
+//~ output: void
+static void benchCompression(const char *name,
+  const std::vector<trajectoryPoint> &poses, float maxXYError,
+  float maxTethaError){
+
+  trajectoryEncoder encoder(maxXYError, maxTethaError);
+  trajectoryDecoder decoder;
+  std::vector<trajectoryPoint> keyPoints;
+  char label[64];
+
+  double start = nowNs();
+  for (const trajectoryPoint &point : poses){
+    encoder.addPose(point.timestampMS, point.pose);
+  }
+  encoder.flush();
+  double encodeNs = nowNs() - start;
+
+  const std::vector<uint8_t> &bytes = encoder.getBytes();
+  start = nowNs();
+  decoder.decode(bytes.data(), bytes.size(), keyPoints);
+  double decodeNs = nowNs() - start;
+
+  std::snprintf(label, sizeof(label), "compress %s %.0fcm %.3frad", name,
+    maxXYError*100, maxTethaError);
+  report(label, encodeNs, poses.size());
+  std::printf("  ratio %.1fx (%zu bytes, %llu key poses), decode %.1f ns/pose\n",
+    (double) poses.size()*16/bytes.size(), bytes.size(),
+    (unsigned long long) encoder.keyPoses(), decodeNs/poses.size());
+}// end function benchCompression
+
+//~ Function: benchParked
+//~ ----------------------------
+//~ Runs the acquisition loops of a parked robot, the mockup acquisitions
+//~   returning no motion, and reports the wakeups and the cpu time used
+//~
+//~ input: bool adaptive; true to enable the adaptive rate
+//~
+//~ output: void
+static void benchParked(bool adaptive){
+  robotPosition robot_position;
+  rateStats stats;
+
+  if (adaptive){
+    robot_position.setAdaptiveRate();
+  }
+
+  double cpuStart = cpuNs();
+  std::thread loops(&robotPosition::updateCoordsThreads, &robot_position,
+    100, 50);
+  std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_PARKED_MS));
+  robot_position.stopLoops();
+  loops.join();
+  double cpuUsed = cpuNs() - cpuStart;
+  robot_position.getRateStats(stats);
+
+  std::printf("parked robot %-8s %6.1f wakeups/s %8.3f ms cpu/s (%s)\n",
+    adaptive ? "adaptive" : "fixed",
+    (stats.gyroWakeups + stats.odometryWakeups)*1000.0/BENCH_PARKED_MS,
+    cpuUsed*1e-6*1000/BENCH_PARKED_MS, stats.idle ? "idle" : "full rate");
+}// end function benchParked
+
+//~ Function: benchUpdate
+//~ ----------------------------
+//~ Times one updateAngle and one updateXY of robotPosition, in float or in
+//~   fixed point as the benchmarks were built. In fixed point the integer
+//~   entry points are timed too, the float ones only add the conversions
+//~
+//~ input: bool integer; true to time updateAngleFixed and updateXYFixed,
+//~   only in a FIXED_POINT_POSITION build
+//~
+//~ output: void
+static void benchUpdate(bool integer){
+  std::vector<float> yawRates(BENCH_UPDATE_SAMPLES);
+  std::vector<std::array<float, 4>> odometries(BENCH_UPDATE_SAMPLES);
+#ifdef FIXED_POINT_POSITION
+  std::vector<int64_t> binaryRates(BENCH_UPDATE_SAMPLES);
+  std::vector<std::array<fixedQ16, 4>> fixedOdometries(BENCH_UPDATE_SAMPLES);
+#endif
+  for (int i = 0; i < BENCH_UPDATE_SAMPLES; i++){
+    float dist = 0.01 + 0.005*cos(i*0.013);
+    yawRates[i] = 0.8*sin(i*0.007);
+    odometries[i] = {dist, dist, dist, dist};
+#ifdef FIXED_POINT_POSITION
+    binaryRates[i] = binaryRateFromRad(yawRates[i]);
+    fixedQ16 fixedDist = fixedFromFloat(dist);
+    fixedOdometries[i] = {fixedDist, fixedDist, fixedDist, fixedDist};
+#endif
+  }
+
+  robotPosition robot_position;
+  std::array<float, COORDS_SIZE> coords;
+
+  double start = nowNs();
+  uint64_t startCycles = cycles();
+  for (long i = 0; i < BENCH_UPDATE_ITERATIONS; i++){
+    int sample = i & (BENCH_UPDATE_SAMPLES - 1);
+#ifdef FIXED_POINT_POSITION
+    if (integer){
+      robot_position.updateAngleFixed(binaryRates[sample], 10);
+      robot_position.updateXYFixed(fixedOdometries[sample], 10);
+      continue;
+    }
+#endif
+    robot_position.updateAngle(yawRates[sample], 10);
+    robot_position.updateXY(odometries[sample], 10);
+  }
+  uint64_t usedCycles = cycles() - startCycles;
+  double elapsed = nowNs() - start;
+  robot_position.getCoords(coords);
+
+#ifdef FIXED_POINT_POSITION
+  report(integer ? "update fixed point, integer inputs" :
+    "update fixed point, float inputs", elapsed, BENCH_UPDATE_ITERATIONS);
+#else
+  report("update float", elapsed, BENCH_UPDATE_ITERATIONS);
+#endif
+  std::printf("%-40s %10.1f cycles/update (x %.1f y %.1f)\n", "",
+    (double) usedCycles/BENCH_UPDATE_ITERATIONS, coords[0], coords[1]);
+}// end function benchUpdate
+
+//~ Function: benchBatch
+//~ ----------------------------
+//~ Times the integration of recorded samples with the per-sample calls of
+//~   the acquisition loops, one lock and one pose per sample, and with
+//~   integrate, with and without the output poses
+//~
+//~ output: void
+static void benchBatch(void){
+  std::vector<gyroSample> gyroSamples(BENCH_BATCH_SAMPLES);
+  std::vector<odometrySample> odometrySamples(BENCH_BATCH_SAMPLES/2);
+  std::vector<trajectoryPoint> poses(BENCH_BATCH_SAMPLES*3/2);
+  for (uint32_t i = 0; i < BENCH_BATCH_SAMPLES; i++){
+    gyroSamples[i] = {(float) (0.6*sin(i*0.01)), i*10};
+  }
+  for (uint32_t i = 0; i < BENCH_BATCH_SAMPLES/2; i++){
+    float dist = 0.01 + 0.004*cos(i*0.02);
+    odometrySamples[i] = {{dist, dist, dist, dist}, i*20 + 3};
+  }
+  long samples = gyroSamples.size() + odometrySamples.size();
+
+  //the per-sample calls as updateAngleLoop and updateXYLoop make them,
+  //merged in timestamp order like integrate does
+  robotPosition robot_position;
+  double start = nowNs();
+  size_t odometryIndex = 0;
+  for (const gyroSample &gyro : gyroSamples){
+    while (odometryIndex < odometrySamples.size() &&
+      odometrySamples[odometryIndex].timestampMS < gyro.timestampMS){
+
+      const odometrySample &odometry = odometrySamples[odometryIndex++];
+      std::lock_guard<std::mutex> lock(robot_position.stateMutex);
+      robot_position.updateXY(odometry.odometry,
+        odometry.timestampMS - robot_position.lastXYUpdateMS);
+      robot_position.lastXYUpdateMS = odometry.timestampMS;
+      robot_position.emitPose(odometry.timestampMS);
+    }
+    std::lock_guard<std::mutex> lock(robot_position.stateMutex);
+    robot_position.updateAngle(gyro.yawRate,
+      gyro.timestampMS - robot_position.lastAngleUpdateMS);
+    robot_position.lastAngleUpdateMS = gyro.timestampMS;
+  }
+  report("per-sample updates", nowNs() - start, samples);
+
+  robotPosition batch_position;
+  start = nowNs();
+  batch_position.integrate(gyroSamples, odometrySamples);
+  report("batch integrate", nowNs() - start, samples);
+
+  robotPosition poses_position;
+  start = nowNs();
+  poses_position.integrate(gyroSamples, odometrySamples, poses);
+  report("batch integrate with poses", nowNs() - start, samples);
+
+  std::printf("%-40s x %.3f / %.3f / %.3f\n", "", robot_position.coords[0],
+    batch_position.coords[0], poses.back().pose[0]);
+}// end function benchBatch
+
+//~ Function: driveYawRate
+//~ ----------------------------
+//~ input: double t; the time in seconds
+//~
+//~ output: double; the yaw rate of the benchmark drive at t
+static double driveYawRate(double t){
+  return 0.3 + 0.8*sin(0.5*t);
+}// end function driveYawRate
+
+//~ Function: driveTetha
+//~ ----------------------------
+//~ input: double t; the time in seconds
+//~
+//~ output: double; the angle of the benchmark drive at t, integral of the
+//~   yaw rate
+static double driveTetha(double t){
+  return 0.3*t - 1.6*(cos(0.5*t) - 1);
+}// end function driveTetha
+
+//~ Function: driveDist
+//~ ----------------------------
+//~ input: double t; the time in seconds
+//~
+//~ output: double; the distance traveled at t, the speed is 1 + 0.3cos(0.3t)
+static double driveDist(double t){
+  return t + sin(0.3*t);
+}// end function driveDist
+
+//~ Function: benchIntegration
+//~ ----------------------------
+//~ Prints the final position error of each integration scheme on a drive
+//~   with a varying yaw rate and speed, sampled at several rates
+//~
+//~ output: void
+static void benchIntegration(void){
+  //the reference drive, midpoint rule on a fine step in double
+  double x = 0;
+  double y = 0;
+  for (double t = 0; t < BENCH_DRIVE_S - BENCH_DRIVE_STEP_S/2;
+    t += BENCH_DRIVE_STEP_S){
+
+    double dist = driveDist(t + BENCH_DRIVE_STEP_S) - driveDist(t);
+    double tetha = driveTetha(t + BENCH_DRIVE_STEP_S/2);
+    x += dist*cos(tetha);
+    y += dist*sin(tetha);
+  }
+
+  const char *names[] = {"euler", "midpoint", "arc", "rk4"};
+  const int rates[] = {5, 10, 20, 50, 100, 200};
+  std::printf("%-40s", "position error (mm) at rate (Hz)");
+  for (int rate : rates){
+    std::printf(" %8d", rate);
+  }
+  std::printf("\n");
+
+  for (int scheme = INTEGRATION_EULER; scheme <= INTEGRATION_RK4; scheme++){
+    std::printf("%-40s", names[scheme]);
+    for (int rate : rates){
+      uint32_t periodMS = 1000/rate;
+      uint32_t samples = BENCH_DRIVE_S*1000/periodMS;
+      std::vector<gyroSample> gyroSamples(samples + 1);
+      std::vector<odometrySample> odometrySamples(samples + 1);
+      for (uint32_t i = 0; i <= samples; i++){
+        double t = i*periodMS/1000.0;
+        float dist = i == 0 ? 0 : driveDist(t) - driveDist(t - periodMS/1000.0);
+        gyroSamples[i] = {(float) driveYawRate(t), i*periodMS};
+        odometrySamples[i] = {{dist, dist, dist, dist}, i*periodMS};
+      }
+
+      robotPosition robot_position;
+      robot_position.setIntegration(scheme);
+      robot_position.integrate(gyroSamples, odometrySamples);
+      std::printf(" %8.2f", 1000*hypot(robot_position.coords[0] - x,
+        robot_position.coords[1] - y));
+    }
+    std::printf("\n");
+  }
+}// end function benchIntegration
+
+//~ Function: extraSource
+//~ ----------------------------
+//~ A source sharing the event loop with the robot tasks, it only wakes up
+//~   at the acquisition frequency
+//~
+//~ input: eventLoop &loop; the loop it runs on, std::atomic<bool> &running;
+//~   false once the source must return
+//~
+//~ output: sensorTask; the task to spawn
+static sensorTask extraSource(eventLoop &loop, std::atomic<bool> &running){
+  uint64_t deadlineNs = eventLoop::nowNs();
+
+  while (running){
+    deadlineNs += 1000000000/BENCH_ACQUISITION_HZ;
+    co_await loop.sleepUntil(deadlineNs);
+  }
+}// end function extraSource
+
+//~ Function: benchAcquisition
+//~ ----------------------------
+//~ Runs the gyrometer and odometry acquisitions at BENCH_ACQUISITION_HZ,
+//~   either with updateCoordsThreads or as tasks of one event loop next to
+//~   other sources, and reports the wakeups, how late they are and the cpu
+//~   time used. Each wakeup is timed against the time it was due: the end
+//~   of the relative sleep for the threads, the absolute deadline for the
+//~   tasks
+//~
+//~ input: bool tasks; true to use the event loop, int sources; the number
+//~   of sources, the two robot ones included
+//~
+//~ output: void
+static void benchAcquisition(bool tasks, int sources){
+  robotPosition robot_position;
+  rateStats stats;
+  eventLoop loop;
+  eventLoopStats loopStats;
+  std::atomic<bool> running{true};
+  double wakeups;
+  double meanLateUs;
+  double maxLateUs;
+
+  double cpuStart = cpuNs();
+  if (tasks){
+    robot_position.updateCoordsTasks(loop, BENCH_ACQUISITION_HZ,
+      BENCH_ACQUISITION_HZ);
+    for (int i = 2; i < sources; i++){
+      loop.spawn(extraSource(loop, running));
+    }
+    std::thread loopThread(&eventLoop::run, &loop);
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_ACQUISITION_MS));
+    robot_position.stopLoops();
+    running = false;
+    loopThread.join();
+
+    loop.getStats(loopStats);
+    wakeups = loopStats.timerWakeups;
+    meanLateUs = loopStats.totalLateNs*1e-3/loopStats.timerWakeups;
+    maxLateUs = loopStats.maxLateNs*1e-3;
+  }
+  else{
+    std::thread loops(&robotPosition::updateCoordsThreads, &robot_position,
+      BENCH_ACQUISITION_HZ, BENCH_ACQUISITION_HZ);
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_ACQUISITION_MS));
+    robot_position.stopLoops();
+    loops.join();
+
+    robot_position.getRateStats(stats);
+    wakeups = stats.gyroWakeups + stats.odometryWakeups;
+    meanLateUs = stats.totalLateNs*1e-3/stats.sleeps;
+    maxLateUs = stats.maxLateNs*1e-3;
+  }
+  double cpuUsed = cpuNs() - cpuStart;
+
+  std::printf("acquisition %-7s %4d sources %3d threads %9.0f wakeups/s "
+    "late %7.1f us mean %8.1f us max %7.2f ms cpu/s\n",
+    tasks ? "tasks" : "threads", sources, tasks ? 1 : 2,
+    wakeups*1000/BENCH_ACQUISITION_MS, meanLateUs, maxLateUs,
+    cpuUsed*1e-6*1000/BENCH_ACQUISITION_MS);
+}// end function benchAcquisition
+
+int main(){
+#ifdef FIXED_POINT_POSITION
+  //the fixed point build is only there to compare the update paths
+  benchUpdate(false);
+  benchUpdate(true);
+  return 0;
+#endif
+
+  benchFleet();
+  benchCheckpoint();
+  benchSmoother(400, 0);
+  benchSmoother(400, 400);
+  benchSmoother(1000, 400);
+
+  std::vector<trajectoryPoint> synthetic;
+  std::vector<trajectoryPoint> replayed;
+  syntheticTrajectory(synthetic);
+  replayedTrajectory(replayed);
+  benchCompression("synthetic", synthetic, 0.01, 0.01);
+  benchCompression("synthetic", synthetic, 0.05, 0.02);
+  benchCompression("replayed", replayed, 0.01, 0.01);
+  benchCompression("replayed", replayed, 0.05, 0.02);
+
+  benchParked(false);
+  benchParked(true);
+
+  benchUpdate(false);
+
+  benchBatch();
+
+  benchIntegration();
+
+  benchAcquisition(false, 2);
+  benchAcquisition(true, 2);
+  benchAcquisition(true, 64);
+  benchAcquisition(true, 1024);
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T17:48:05+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: dead_reckoning_c.h
+ * @Last modified time: 2026-10-19T17:48:05+02:00
+ */
+
+#ifndef DEAD_RECKONING_C_H
+#define DEAD_RECKONING_C_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the integration schemes, the same as in position_library.h
+#ifndef INTEGRATION_EULER
+#define INTEGRATION_EULER          0
+#define INTEGRATION_MIDPOINT       1
+#define INTEGRATION_ARC            2
+#define INTEGRATION_RK4            3
+#endif
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////structs//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//arrays of the samples and poses (or numpy structured arrays with the same
+//fields) are read and written without any call per sample
+
+//~ Struct: deadReckoningGyroSample
+//~ ----------------------------
+//~ A gyrometer acquisition, 8 bytes
+typedef struct{
+  //the yaw rate in rad/s
+  float yawRate;
+  //the time of the acquisition in miliseconds
+  uint32_t timestampMS;
+} deadReckoningGyroSample;
+
+//~ Struct: deadReckoningOdometrySample
+//~ ----------------------------
+//~ An odometry acquisition, 20 bytes
+typedef struct{
+  //the distance traveled by the 4 wheels as :
+  //[left_back, right_back, left_front, right_front]
+  float odometry[4];
+  //the time of the acquisition in miliseconds
+  uint32_t timestampMS;
+} deadReckoningOdometrySample;
+
+//~ Struct: deadReckoningPose
+//~ ----------------------------
+//~ A timestamped pose, 16 bytes
+typedef struct{
+  //the time in miliseconds of the sample that gave the pose
+  uint32_t timestampMS;
+  //the pose as [x, y, tetha]
+  float pose[3];
+} deadReckoningPose;
+
+//~ Struct: deadReckoning
+//~ ----------------------------
+//~ The positioning of one robot, only handled through pointers
+typedef struct deadReckoning deadReckoning;
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+/////////////////////////////functions//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: deadReckoningCreate
+//~ ----------------------------
+//~ Creates the positioning of a robot at [0, 0, 0]
+//~
+//~ output: deadReckoning *; the positioning, NULL if out of memory
+deadReckoning *deadReckoningCreate(void);
+
+//~ Function: deadReckoningDestroy
+//~ ----------------------------
+//~ input: deadReckoning *position; the positioning to free, may be NULL
+//~
+//~ output: void
+void deadReckoningDestroy(deadReckoning *position);
+
+//~ Function: deadReckoningSetIntegration
+//~ ----------------------------
+//~ input: deadReckoning *position; the positioning, int scheme; one of the
+//~   INTEGRATION_ constants
+//~
+//~ output: int is 1 if suceess, -1 if the scheme is unknown
+int deadReckoningSetIntegration(deadReckoning *position, int scheme);
+
+//~ Function: deadReckoningSetPose
+//~ ----------------------------
+//~ Moves the robot, for example to start a replay from a known pose
+//~
+//~ input: deadReckoning *position; the positioning, const float *pose; the
+//~   [x, y, tetha], uint32_t timestampMS; the time of the pose in
+//~   miliseconds, the next samples are integrated from it
+//~
+//~ output: int is 1 if suceess, -1 if a pointer is NULL
+int deadReckoningSetPose(deadReckoning *position, const float *pose,
+  uint32_t timestampMS);
+
+//~ Function: deadReckoningGetPose
+//~ ----------------------------
+//~ input: deadReckoning *position; the positioning
+//~ inout: float *pose; the returned [x, y, tetha]
+//~
+//~ output: int is 1 if suceess, -1 if a pointer is NULL
+int deadReckoningGetPose(deadReckoning *position, float *pose);
+
+//~ Function: deadReckoningIntegrate
+//~ ----------------------------
+//~ Integrates whole arrays of samples in one call, merged by timestamp.
+//~   The arrays are read and written in place, nothing is copied or
+//~   allocated
+//~
+//~ input: deadReckoning *position; the positioning,
+//~   const deadReckoningGyroSample *gyroSamples, size_t gyroCount; the
+//~   gyrometer samples sorted by timestamp,
+//~   const deadReckoningOdometrySample *odometrySamples,
+//~   size_t odometryCount; the odometry samples sorted by timestamp,
+//~   size_t posesCapacity; the size of the poses array, may be 0
+//~ inout: deadReckoningPose *poses; the pose after each sample, written
+//~   until the array is full, may be NULL if posesCapacity is 0
+//~
+//~ output: ptrdiff_t; the number of poses written, -1 if a pointer is NULL
+ptrdiff_t deadReckoningIntegrate(deadReckoning *position,
+  const deadReckoningGyroSample *gyroSamples, size_t gyroCount,
+  const deadReckoningOdometrySample *odometrySamples, size_t odometryCount,
+  deadReckoningPose *poses, size_t posesCapacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEAD_RECKONING_C_H
@@ -0,0 +1,260 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T19:24:37+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: event_loop.h
+ * @Last modified time: 2026-10-19T19:24:37+02:00
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <exception>
+#include <coroutine>
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the maximum number of events handled per wakeup of the loop
+#define EVENT_LOOP_EVENTS          64
+//the number of timers the loop has room for before growing
+#define EVENT_LOOP_TIMERS          64
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////structs//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Struct: sensorTask
+//~ ----------------------------
+//~ The coroutine of a sensor source, given to eventLoop::spawn which runs
+//~   it and frees it once it returns
+struct sensorTask{
+  struct promise_type{
+    sensorTask get_return_object(void){
+      return {std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    //the task only starts once spawned
+    std::suspend_always initial_suspend(void) noexcept{
+      return {};
+    }
+    //the loop frees the task when it sees it done
+    std::suspend_always final_suspend(void) noexcept{
+      return {};
+    }
+    void return_void(void){
+    }
+    void unhandled_exception(void){
+      std::terminate();
+    }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+//~ Struct: eventLoopStats
+//~ ----------------------------
+//~ The activity of the event loop
+struct eventLoopStats{
+  //the number of timers that resumed a task
+  uint64_t timerWakeups;
+  //the number of file descriptors that resumed a task
+  uint64_t fdWakeups;
+  //the total and maximum delay between a timer deadline and the task
+  //resuming, in nanoseconds
+  uint64_t totalLateNs;
+  uint64_t maxLateNs;
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////class///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Class: eventLoop
+//~ ----------------------------
+//~ Runs any number of sensor coroutines on the thread calling run. A task
+//~   suspends on a deadline (sleepUntil) or on a file descriptor becoming
+//~   readable (readable), and the loop resumes it from a single epoll_wait;
+//~   all the timers share one timerfd armed on the nearest deadline.
+class eventLoop{
+  public:
+
+    //~ Struct: timerAwaiter
+    //~ ----------------------------
+    //~ Suspends a task until a deadline
+    struct timerAwaiter{
+      eventLoop &loop;
+      uint64_t deadlineNs;
+
+      bool await_ready(void){
+        return deadlineNs <= nowNs();
+      }
+      void await_suspend(std::coroutine_handle<> handle){
+        loop.addTimer(deadlineNs, handle);
+      }
+      void await_resume(void){
+      }
+    };
+
+    //~ Struct: fdAwaiter
+    //~ ----------------------------
+    //~ Suspends a task until a file descriptor is readable, co_await gives
+    //~   1 then, or -1 if the file descriptor cannot be watched
+    struct fdAwaiter{
+      eventLoop &loop;
+      int fd;
+      std::coroutine_handle<> handle;
+      int result;
+
+      bool await_ready(void){
+        return false;
+      }
+      bool await_suspend(std::coroutine_handle<> handle){
+        this->handle = handle;
+        result = loop.addWaiter(this);
+        return result > 0;
+      }
+      int await_resume(void){
+        return result;
+      }
+    };
+
+    eventLoop(void);
+    ~eventLoop(void);
+
+    //~ Function: spawn
+    //~ ----------------------------
+    //~ Adds a task to the loop, it starts at the next run
+    //~
+    //~ input: sensorTask task; the task, the loop frees it
+    //~
+    //~ output: void
+    void spawn(sensorTask task);
+
+    //~ Function: run
+    //~ ----------------------------
+    //~ Runs the tasks until they all returned or stop is called. The tasks
+    //~   still suspended then stay in the loop and a later run resumes them
+    //~
+    //~ output: int is 1 if suceess, -1 if the loop could not be created or
+    //~   waiting failed
+    int run(void);
+
+    //~ Function: stop
+    //~ ----------------------------
+    //~ Makes run return, can be called from any thread. Called while the
+    //~   loop does not run, the next run returns once the new tasks started
+    //~
+    //~ output: void
+    void stop(void);
+
+    //~ Function: sleepUntil
+    //~ ----------------------------
+    //~ input: uint64_t deadlineNs; the time given by nowNs to resume at
+    //~
+    //~ output: timerAwaiter; to co_await
+    timerAwaiter sleepUntil(uint64_t deadlineNs);
+
+    //~ Function: readable
+    //~ ----------------------------
+    //~ input: int fd; the file descriptor to wait for
+    //~
+    //~ output: fdAwaiter; to co_await
+    fdAwaiter readable(int fd);
+
+    //~ Function: getStats
+    //~ ----------------------------
+    //~ inout: eventLoopStats &stats; the returned statistics
+    //~
+    //~ output: void
+    void getStats(eventLoopStats &stats);
+
+    //~ Function: nowNs
+    //~ ----------------------------
+    //~ output: uint64_t; the monotonic time in nanoseconds of the deadlines
+    static uint64_t nowNs(void);
+
+  private:
+
+    //a task waiting for a deadline
+    struct timerEntry{
+      uint64_t deadlineNs;
+      std::coroutine_handle<> handle;
+    };
+
+    //the epoll instance, the timerfd of the timers and the eventfd of stop
+    int epollFd = -1;
+    int timerFd = -1;
+    int stopFd = -1;
+    //false once stop was called, until run returns
+    std::atomic<bool> running{true};
+
+    //the tasks spawned and not returned yet
+    std::vector<std::coroutine_handle<>> tasks;
+    //the tasks to start at the next run
+    std::vector<std::coroutine_handle<>> started;
+    //the timers as a min heap on the deadline
+    std::vector<timerEntry> timers;
+    //the deadline the timerfd is armed on, 0 if disarmed
+    uint64_t armedNs = 0;
+
+    //the activity counters
+    eventLoopStats stats = {0, 0, 0, 0};
+
+    //~ Function: addTimer
+    //~ ----------------------------
+    //~ input: uint64_t deadlineNs; when to resume, std::coroutine_handle<>
+    //~   handle; the task to resume
+    //~
+    //~ output: void
+    void addTimer(uint64_t deadlineNs, std::coroutine_handle<> handle);
+
+    //~ Function: addWaiter
+    //~ ----------------------------
+    //~ input: fdAwaiter *awaiter; the task and the file descriptor to watch
+    //~
+    //~ output: int is 1 if suceess, -1 if epoll refused the file descriptor
+    int addWaiter(fdAwaiter *awaiter);
+
+    //~ Function: fireTimers
+    //~ ----------------------------
+    //~ Resumes the tasks whose deadline passed, then arms the timerfd on the
+    //~   next deadline
+    //~
+    //~ output: void
+    void fireTimers(void);
+
+    //~ Function: armTimer
+    //~ ----------------------------
+    //~ input: uint64_t deadlineNs; the deadline to arm the timerfd on, 0 to
+    //~   disarm it
+    //~
+    //~ output: void
+    void armTimer(uint64_t deadlineNs);
+
+    //~ Function: resume
+    //~ ----------------------------
+    //~ Resumes a task and frees it if it returned
+    //~
+    //~ input: std::coroutine_handle<> handle; the task
+    //~
+    //~ output: void
+    void resume(std::coroutine_handle<> handle);
+};
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,228 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T15:41:08+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: fixed_point.h
+ * @Last modified time: 2026-10-19T15:41:08+02:00
+ */
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the number of fractional bits of a fixed point position (Q15.16)
+#define FIXED_POSITION_BITS        16
+//the number of fractional bits of a sine or cosine (Q1.30)
+#define FIXED_SINCOS_BITS          30
+//log2 of the number of entries of the quarter sine table
+#define SINCOS_TABLE_BITS          8
+//the number of entries of the quarter sine table
+#define SINCOS_TABLE_SIZE          (1 << SINCOS_TABLE_BITS)
+//the number of binary angle units in one turn
+#define BINARY_ANGLE_TURN          4294967296.0
+//the value of pi for the compile time table
+#define FIXED_PI                   3.14159265358979323846
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////types////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//a position in meters in Q15.16: +/-32km with a 15um resolution
+typedef int32_t fixedQ16;
+//an angle where one turn is 2^32, the integer overflow wraps it for free
+typedef uint32_t binaryAngle;
+
+//~ Struct: fixedPose
+//~ ----------------------------
+//~ The robot pose in fixed point
+struct fixedPose{
+  //x and y in Q15.16 meters
+  fixedQ16 x;
+  fixedQ16 y;
+  //the angle between the x axis and the robot direction
+  binaryAngle tetha;
+};
+
+//~ Struct: sinTableType
+//~ ----------------------------
+//~ The first quarter of a sine period in Q1.30, with the pi/2 end point
+struct sinTableType{
+  int32_t values[SINCOS_TABLE_SIZE + 1];
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////sine table///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: makeSinTable
+//~ ----------------------------
+//~ Builds the quarter sine table at compile time with a Taylor series, so
+//~   the target never computes a floating point sine
+//~
+//~ output: sinTableType; the table
+constexpr sinTableType makeSinTable(void){
+  sinTableType table = {};
+
+  for (int i = 0; i <= SINCOS_TABLE_SIZE; i++){
+    double x = FIXED_PI/2*i/SINCOS_TABLE_SIZE;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++){
+      term *= -x*x/((2*n)*(2*n + 1));
+      sum += term;
+    }
+    table.values[i] = (int32_t) (sum*(1 << FIXED_SINCOS_BITS) + 0.5);
+  }
+
+  return table;
+}// end function makeSinTable
+
+//the quarter sine table, 1KB of read only data
+inline constexpr sinTableType sinTable = makeSinTable();
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////conversions/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: fixedFromFloat
+//~ ----------------------------
+//~ input: float value; a position in meters
+//~
+//~ output: fixedQ16; the same position in Q15.16
+inline fixedQ16 fixedFromFloat(float value){
+  float scaled = value*(1 << FIXED_POSITION_BITS);
+  return (fixedQ16) (scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}// end function fixedFromFloat
+
+//~ Function: floatFromFixed
+//~ ----------------------------
+//~ input: fixedQ16 value; a position in Q15.16
+//~
+//~ output: float; the same position in meters
+inline float floatFromFixed(fixedQ16 value){
+  return (float) value/(1 << FIXED_POSITION_BITS);
+}// end function floatFromFixed
+
+//~ Function: binaryAngleFromRad
+//~ ----------------------------
+//~ input: float angle; an angle in rads, any number of turns
+//~
+//~ output: binaryAngle; the same angle modulo one turn
+inline binaryAngle binaryAngleFromRad(float angle){
+  return (binaryAngle) (int64_t) (angle*
+    (float) (BINARY_ANGLE_TURN/(2*FIXED_PI)));
+}// end function binaryAngleFromRad
+
+//~ Function: radFromBinaryAngle
+//~ ----------------------------
+//~ input: binaryAngle angle; an angle
+//~
+//~ output: float; the same angle in rads in [-pi, pi[
+inline float radFromBinaryAngle(binaryAngle angle){
+  return (int32_t) angle*(float) (2*FIXED_PI/BINARY_ANGLE_TURN);
+}// end function radFromBinaryAngle
+
+//~ Function: binaryRateFromRad
+//~ ----------------------------
+//~ input: float yawRate; a yaw rate in rad/s
+//~
+//~ output: int64_t; the same yaw rate in binary angle units per second
+inline int64_t binaryRateFromRad(float yawRate){
+  return (int64_t) (yawRate*(float) (BINARY_ANGLE_TURN/(2*FIXED_PI)));
+}// end function binaryRateFromRad
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+/////////////////////////////functions//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: fixedSin
+//~ ----------------------------
+//~ Calculates a sine from the quarter table with a linear interpolation,
+//~   the error stays under 5e-6
+//~
+//~ input: binaryAngle angle; the angle
+//~
+//~ output: int32_t; the sine in Q1.30
+inline int32_t fixedSin(binaryAngle angle){
+  //the two upper bits give the quarter, the rest the phase in the quarter
+  uint32_t quarter = angle >> 30;
+  uint32_t phase = angle & 0x3FFFFFFF;
+  if (quarter & 1){
+    phase = 0x40000000 - phase;
+  }
+
+  uint32_t index = phase >> (30 - SINCOS_TABLE_BITS);
+  uint32_t fraction = phase & ((1 << (30 - SINCOS_TABLE_BITS)) - 1);
+  int32_t value = sinTable.values[index];
+  if (index < SINCOS_TABLE_SIZE){
+    value += (int32_t) (((int64_t) (sinTable.values[index + 1] - value)*
+      fraction) >> (30 - SINCOS_TABLE_BITS));
+  }
+
+  return quarter & 2 ? -value : value;
+}// end function fixedSin
+
+//~ Function: fixedCos
+//~ ----------------------------
+//~ input: binaryAngle angle; the angle
+//~
+//~ output: int32_t; the cosine in Q1.30
+inline int32_t fixedCos(binaryAngle angle){
+  return fixedSin(angle + 0x40000000);
+}// end function fixedCos
+
+//~ Function: fixedUpdateAngle
+//~ ----------------------------
+//~ Integrates a yaw rate over a time step, the angle wraps by itself
+//~
+//~ inout: fixedPose &pose; the pose updated
+//~ input: int64_t yawRate; the yaw rate in binary angle units per second,
+//~   uint32_t deltaTMs; the time step in miliseconds
+//~
+//~ output: void
+inline void fixedUpdateAngle(fixedPose &pose, int64_t yawRate,
+  uint32_t deltaTMs){
+
+  pose.tetha += (binaryAngle) (yawRate*deltaTMs/1000);
+}// end function fixedUpdateAngle
+
+//~ Function: fixedUpdateXY
+//~ ----------------------------
+//~ Moves the pose of a distance along its current angle
+//~
+//~ inout: fixedPose &pose; the pose updated
+//~ input: fixedQ16 dist; the distance traveled in Q15.16
+//~
+//~ output: void
+inline void fixedUpdateXY(fixedPose &pose, fixedQ16 dist){
+  //round to nearest, truncating would drift by half a unit per update
+  const int64_t half = (int64_t) 1 << (FIXED_SINCOS_BITS - 1);
+
+  pose.x += (fixedQ16) (((int64_t) dist*fixedCos(pose.tetha) + half) >>
+    FIXED_SINCOS_BITS);
+  pose.y += (fixedQ16) (((int64_t) dist*fixedSin(pose.tetha) + half) >>
+    FIXED_SINCOS_BITS);
+}// end function fixedUpdateXY
+
+#endif // FIXED_POINT_H
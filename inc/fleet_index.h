@@ -0,0 +1,215 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T09:12:40+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: fleet_index.h
+ * @Last modified time: 2026-10-19T09:12:40+02:00
+ */
+
+#ifndef FLEET_INDEX_H
+#define FLEET_INDEX_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "position_library.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the default side of a grid cell in meters
+#define FLEET_DEFAULT_CELL_SIZE    2.0
+//the largest cell index on each axis, coordinates farther away are clamped
+#define FLEET_MAX_CELL             (1 << 30)
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////class///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Class: fleetPoses
+//~ ----------------------------
+//~ Stores the last pose of every cart of the fleet and indexes them on a
+//~   uniform grid so that proximity and zone queries only visit the cells
+//~   around the query instead of the whole fleet
+class fleetPoses{
+  public:
+
+    //~ Function: fleetPoses
+    //~ ----------------------------
+    //~ Constructor
+    //~
+    //~ input: float cellSizeM; the side of a grid cell in meters, it should be
+    //~   close to the usual query radius
+    fleetPoses(float cellSizeM = FLEET_DEFAULT_CELL_SIZE);
+    ~fleetPoses(void);
+
+    //~ Function: updatePose
+    //~ ----------------------------
+    //~ Inserts a cart or updates its pose. If the cart stays in the same cell
+    //~   only the pose is rewritten, otherwise it is moved to its new cell in
+    //~   constant time
+    //~
+    //~ input: uint32_t cartId; the cart identifier,
+    //~   std::array<float, COORDS_SIZE> pose; the cart pose as [x, y, tetha]
+    //~
+    //~ output: bool; true if the pose was stored, false if x or y is not finite
+    bool updatePose(uint32_t cartId, std::array<float, COORDS_SIZE> pose);
+
+    //~ Function: removeCart
+    //~ ----------------------------
+    //~ Removes a cart from the store
+    //~
+    //~ input: uint32_t cartId; the cart identifier
+    //~
+    //~ output: bool; true if the cart was stored, false otherwise
+    bool removeCart(uint32_t cartId);
+
+    //~ Function: getPose
+    //~ ----------------------------
+    //~ Gets the last pose of a cart
+    //~
+    //~ input: uint32_t cartId; the cart identifier
+    //~ inout: std::array<float, COORDS_SIZE> &pose; the returned pose
+    //~
+    //~ output: bool; true if the cart was stored, false otherwise
+    bool getPose(uint32_t cartId, std::array<float, COORDS_SIZE> &pose) const;
+
+    //~ Function: size
+    //~ ----------------------------
+    //~ output: size_t; the number of carts stored
+    size_t size(void) const;
+
+    //~ Function: radiusQuery
+    //~ ----------------------------
+    //~ Finds all the carts within a distance of a point
+    //~
+    //~ input: std::array<float, XY_COORDS_SIZE> center; the [x, y] point,
+    //~   float radiusM; the search radius in meters
+    //~ inout: std::vector<uint32_t> &cartIds; cleared then filled with the ids
+    //~   of the carts found, in no particular order
+    //~
+    //~ output: size_t; the number of carts found, 0 if an input is not finite
+    size_t radiusQuery(std::array<float, XY_COORDS_SIZE> center, float radiusM,
+      std::vector<uint32_t> &cartIds) const;
+
+    //~ Function: zoneQuery
+    //~ ----------------------------
+    //~ Finds all the carts inside a rectangular zone aligned with the axis
+    //~
+    //~ input: std::array<float, XY_COORDS_SIZE> minCorner; the [x, y] lower
+    //~   corner, std::array<float, XY_COORDS_SIZE> maxCorner; the [x, y] upper
+    //~   corner
+    //~ inout: std::vector<uint32_t> &cartIds; cleared then filled with the ids
+    //~   of the carts found, in no particular order
+    //~
+    //~ output: size_t; the number of carts found, 0 if an input is not finite
+    size_t zoneQuery(std::array<float, XY_COORDS_SIZE> minCorner,
+      std::array<float, XY_COORDS_SIZE> maxCorner,
+      std::vector<uint32_t> &cartIds) const;
+
+    //~ Function: kNearest
+    //~ ----------------------------
+    //~ Finds the k carts closest to a point by visiting rings of cells around
+    //~   it until no unvisited cell can hold a closer cart
+    //~
+    //~ input: std::array<float, XY_COORDS_SIZE> center; the [x, y] point,
+    //~   size_t k; the number of carts wanted
+    //~ inout: std::vector<uint32_t> &cartIds; cleared then filled with the ids
+    //~   of the carts found, from the closest to the farthest
+    //~
+    //~ output: size_t; the number of carts found, min(k, size())
+    size_t kNearest(std::array<float, XY_COORDS_SIZE> center, size_t k,
+      std::vector<uint32_t> &cartIds) const;
+
+  private:
+
+    //the information stored for each cart
+    struct cartEntry{
+      //the cart identifier
+      uint32_t cartId;
+      //the cart pose as [x, y, tetha]
+      std::array<float, COORDS_SIZE> pose;
+      //the key of the cell the cart is in
+      uint64_t cellKey;
+      //the position of the cart in its cell list
+      uint32_t cellSlot;
+    };
+
+    //the side of a grid cell in meters
+    float cellSize;
+    //the inverse of the cell side, to avoid divisions
+    float invCellSize;
+    //the carts stored contiguously, removals swap with the last one
+    std::vector<cartEntry> carts;
+    //the position of each cart in the carts vector
+    std::unordered_map<uint32_t, uint32_t> cartSlots;
+    //for each non empty cell, the positions in carts of the carts it holds
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+
+    //~ Function: cellCoord
+    //~ ----------------------------
+    //~ input: float coord; a x or y coordinate in meters
+    //~
+    //~ output: int32_t; the index of the cell holding it on that axis, clamped
+    //~   to [-FLEET_MAX_CELL, FLEET_MAX_CELL]. The callers reject the non finite
+    //~   coordinates, a NaN still gives -FLEET_MAX_CELL instead of an undefined
+    //~   cast
+    int32_t cellCoord(float coord) const;
+
+    //~ Function: visitCells
+    //~ ----------------------------
+    //~ Calls a function on every cart of the cells of a box. When the box holds
+    //~   more cells than the map, the occupied cells are scanned instead, so a
+    //~   query never costs more than the number of occupied cells
+    //~
+    //~ input: int32_t cxMin, int32_t cyMin; the lower cell of the box,
+    //~   int32_t cxMax, int32_t cyMax; the upper cell of the box,
+    //~   visitor visit; called with the position in carts of each cart found
+    //~
+    //~ output: void
+    template <typename visitor>
+    void visitCells(int32_t cxMin, int32_t cyMin, int32_t cxMax, int32_t cyMax,
+      visitor visit) const;
+
+    //~ Function: makeCellKey
+    //~ ----------------------------
+    //~ input: int32_t cx, int32_t cy; the cell indexes on the x and y axis
+    //~
+    //~ output: uint64_t; the key of the cell in the cells map
+    uint64_t makeCellKey(int32_t cx, int32_t cy) const;
+
+    //~ Function: insertInCell
+    //~ ----------------------------
+    //~ Adds a cart to the list of a cell
+    //~
+    //~ input: uint32_t slot; the position of the cart in carts,
+    //~   uint64_t key; the key of the cell
+    //~
+    //~ output: void
+    void insertInCell(uint32_t slot, uint64_t key);
+
+    //~ Function: removeFromCell
+    //~ ----------------------------
+    //~ Removes a cart from the list of its cell in constant time by swapping it
+    //~   with the last cart of the list
+    //~
+    //~ input: uint32_t slot; the position of the cart in carts
+    //~
+    //~ output: void
+    void removeFromCell(uint32_t slot);
+};
+
+#endif // FLEET_INDEX_H
@@ -7,6 +7,7 @@
  */
 
 #include <array>
+#include <cstdint>
 
 //~ Function : gyrometerAcq
 //~ ----------------------------
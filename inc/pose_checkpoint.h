@@ -0,0 +1,163 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T10:05:12+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: pose_checkpoint.h
+ * @Last modified time: 2026-10-19T10:05:12+02:00
+ */
+
+#ifndef POSE_CHECKPOINT_H
+#define POSE_CHECKPOINT_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+
+#include "position_library.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the tag at the start of every valid checkpoint record
+#define CHECKPOINT_MAGIC           0x44524350
+//the version of the checkpoint record layout
+#define CHECKPOINT_VERSION         2
+//the size of a checkpoint slot in the file, one page
+#define CHECKPOINT_SLOT_SIZE       4096
+//the number of slots of the file, written alternately
+#define CHECKPOINT_SLOTS           2
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////class///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Class: poseCheckpoint
+//~ ----------------------------
+//~ Periodically saves the robot state in a preallocated file of two slots.
+//~   Each new checkpoint overwrites the oldest slot, so a crash in the
+//~   middle of a write always leaves the previous checkpoint intact
+class poseCheckpoint{
+  public:
+    poseCheckpoint(void);
+    ~poseCheckpoint(void);
+
+    //~ Function: openFile
+    //~ ----------------------------
+    //~ Opens the checkpoint file, creates and preallocates it if needed
+    //~
+    //~ input: const char *path; the path of the checkpoint file
+    //~
+    //~ output: int is 1 if suceess, -1 if error
+    int openFile(const char *path);
+
+    //~ Function: closeFile
+    //~ ----------------------------
+    //~ Closes the checkpoint file
+    //~
+    //~ output: void
+    void closeFile(void);
+
+    //~ Function: writeState
+    //~ ----------------------------
+    //~ Writes a state in the oldest slot and flushes it to the disk
+    //~
+    //~ input: const robotState &state; the state to checkpoint
+    //~
+    //~ output: int is 1 if suceess, -1 if error
+    int writeState(const robotState &state);
+
+    //~ Function: readLatest
+    //~ ----------------------------
+    //~ Reads the most recent valid checkpoint of the file
+    //~
+    //~ inout: robotState &state; the returned state
+    //~
+    //~ output: int is 1 if suceess, -1 if there is no valid checkpoint
+    int readLatest(robotState &state);
+
+    //~ Function: checkpointLoop
+    //~ ----------------------------
+    //~ The loop that checkpoints the robot state. It runs on its own thread so
+    //~   the gyrometer and odometry loops never wait for the disk. Once
+    //~   stopLoop is called it writes a last checkpoint and returns
+    //~
+    //~ input: robotPosition &robot; the robot to checkpoint,
+    //~   int periodMs; the time between two checkpoints in miliseconds
+    //~
+    //~ output: void
+    void checkpointLoop(robotPosition &robot, int periodMs);
+
+    //~ Function: stopLoop
+    //~ ----------------------------
+    //~ Makes checkpointLoop return without waiting for the end of its period
+    //~
+    //~ output: void
+    void stopLoop(void);
+
+    //~ Function: getWriteFailures
+    //~ ----------------------------
+    //~ output: uint64_t; the number of checkpoints checkpointLoop could not
+    //~   write
+    uint64_t getWriteFailures(void);
+
+  private:
+
+    //the record written in a slot
+    struct checkpointRecord{
+      //CHECKPOINT_MAGIC when the slot holds a record
+      uint32_t magic;
+      //CHECKPOINT_VERSION of the writer
+      uint32_t version;
+      //incremented at every write, the greatest valid one is the latest
+      uint64_t sequence;
+      //the checkpointed state
+      robotState state;
+      //the crc32 of all the previous fields
+      uint32_t crc;
+    };
+
+    //the checkpoint file descriptor, -1 when closed
+    int fd = -1;
+    //the sequence number of the last record written or read
+    uint64_t sequence = 0;
+    //false once checkpointLoop must return
+    std::atomic<bool> running{true};
+    //the checkpoints checkpointLoop could not write
+    std::atomic<uint64_t> writeFailures{0};
+    //wakes up checkpointLoop when it is stopped
+    std::mutex loopMutex;
+    std::condition_variable loopStopped;
+
+    //~ Function: readSlot
+    //~ ----------------------------
+    //~ Reads and validates the record of a slot
+    //~
+    //~ input: int slot; the slot index
+    //~ inout: checkpointRecord &record; the returned record
+    //~
+    //~ output: int is 1 if the slot holds a valid record, -1 otherwise
+    int readSlot(int slot, checkpointRecord &record);
+
+    //~ Function: crc32
+    //~ ----------------------------
+    //~ Calculates the crc32 of a buffer
+    //~
+    //~ input: const void *data; the buffer, size_t size; its size in bytes
+    //~
+    //~ output: uint32_t; the crc32 of the buffer
+    uint32_t crc32(const void *data, size_t size);
+};
+
+#endif // POSE_CHECKPOINT_H
@@ -0,0 +1,227 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T11:20:31+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: pose_smoother.h
+ * @Last modified time: 2026-10-19T11:20:31+02:00
+ */
+
+#ifndef POSE_SMOOTHER_H
+#define POSE_SMOOTHER_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "position_library.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the default number of poses in the sliding window
+#define SMOOTHER_DEFAULT_WINDOW    400
+//the default standard deviation of a gyrometer angle increment in rads
+#define SMOOTHER_GYRO_STD          0.0005
+//the default standard deviation of an odometry increment in meters
+#define SMOOTHER_ODOMETRY_STD      0.001
+//the default standard deviation of an absolute x or y fix in meters
+#define SMOOTHER_FIX_XY_STD        0.02
+//the default standard deviation of an absolute angle fix in rads
+#define SMOOTHER_FIX_TETHA_STD     0.01
+//the standard deviation given to the oldest pose once the window slides
+#define SMOOTHER_PRIOR_STD         0.0001
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////class///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Class: poseSmoother
+//~ ----------------------------
+//~ Fixed-lag smoother over a sliding window of poses. Each sample links two
+//~   consecutive poses by a traveled distance and an angle variation, and
+//~   absolute fixes pull single poses. The least squares problem is solved
+//~   first on the angles then on x and y; both are tridiagonal systems, so
+//~   every solve costs O(window) per sample whatever the fixes. Sliding the
+//~   window moves each fix by one row, so the factorization is only kept
+//~   from one solve to the next while the window holds no fix; otherwise it
+//~   is redone, also in O(window), at every slide.
+//~   It is meant for post-processing, robotPosition stays the low latency
+//~   output.
+class poseSmoother{
+  public:
+
+    //~ Function: poseSmoother
+    //~ ----------------------------
+    //~ Constructor
+    //~
+    //~ input: size_t windowSize; the number of poses in the sliding window,
+    //~   std::array<float, COORDS_SIZE> initialPose; the [x, y, tetha] pose of
+    //~   the robot before the first sample
+    poseSmoother(size_t windowSize = SMOOTHER_DEFAULT_WINDOW,
+      std::array<float, COORDS_SIZE> initialPose = {0, 0, 0});
+    ~poseSmoother(void);
+
+    //~ Function: setNoise
+    //~ ----------------------------
+    //~ Sets the standard deviations used to weight the measurements
+    //~
+    //~ input: double gyroStd; of an angle increment in rads, double odometryStd;
+    //~   of a distance increment in meters, double fixXYStd; of an absolute x
+    //~   or y in meters, double fixTethaStd; of an absolute angle in rads
+    //~
+    //~ output: void
+    void setNoise(double gyroStd, double odometryStd, double fixXYStd,
+      double fixTethaStd);
+
+    //~ Function: addSample
+    //~ ----------------------------
+    //~ Adds a new pose to the window, linked to the previous one. Once the
+    //~   window is full the oldest pose leaves it and becomes the prior, and
+    //~   the next solve refactorizes if a fix is left in the window
+    //~
+    //~ input: float deltaDist; the distance traveled since the last sample as
+    //~   given by calculateDeltaDist, float deltaTetha; the angle variation
+    //~   since the last sample
+    //~
+    //~ output: void
+    void addSample(float deltaDist, float deltaTetha);
+
+    //~ Function: addFix
+    //~ ----------------------------
+    //~ Adds an absolute measurement of the newest pose
+    //~
+    //~ input: std::array<float, COORDS_SIZE> fix; the measured [x, y, tetha]
+    //~
+    //~ output: void
+    void addFix(std::array<float, COORDS_SIZE> fix);
+
+    //~ Function: solve
+    //~ ----------------------------
+    //~ Smooths all the poses of the window, in O(window)
+    //~
+    //~ output: void
+    void solve(void);
+
+    //~ Function: getPose
+    //~ ----------------------------
+    //~ Gets a pose of the window, as smoothed by the last solve
+    //~
+    //~ input: size_t lag; the number of samples between the newest pose and
+    //~   the one wanted, 0 for the newest
+    //~ inout: std::array<float, COORDS_SIZE> &pose; the returned [x, y, tetha]
+    //~
+    //~ output: int is 1 if suceess, -1 if the lag is outside of the window
+    int getPose(size_t lag, std::array<float, COORDS_SIZE> &pose);
+
+    //~ Function: size
+    //~ ----------------------------
+    //~ output: size_t; the number of poses in the window
+    size_t size(void);
+
+    //~ Function: factorizations
+    //~ ----------------------------
+    //~ output: uint64_t; the number of times the systems were factorized
+    uint64_t factorizations(void);
+
+  private:
+
+    //the information kept for each pose of the window
+    struct smootherNode{
+      //the distance traveled from the previous pose
+      double deltaDist;
+      //the angle variation from the previous pose
+      double deltaTetha;
+      //true if an absolute fix was added on this pose
+      bool hasFix;
+      //the absolute fix as [x, y, tetha], tetha unwrapped
+      std::array<double, COORDS_SIZE> fix;
+      //the current estimate as [x, y, tetha], tetha unwrapped
+      std::array<double, COORDS_SIZE> pose;
+    };
+
+    //the poses of the window, as a ring buffer
+    std::vector<smootherNode> nodes;
+    //the index of the oldest pose in nodes
+    size_t head = 0;
+    //the number of poses in the window
+    size_t count = 0;
+    //the estimate of the oldest pose before the window slid, as [x, y, tetha]
+    std::array<double, COORDS_SIZE> prior;
+
+    //the weights, inverse of the variances
+    double gyroWeight;
+    double odometryWeight;
+    double fixXYWeight;
+    double fixTethaWeight;
+    double priorWeight;
+
+    //the LDLt factorization of the angle system: inverse of the diagonal and
+    //sub-diagonal
+    std::vector<double> tethaD;
+    std::vector<double> tethaL;
+    //the LDLt factorization of the x and y system: inverse of the diagonal and
+    //sub-diagonal
+    std::vector<double> xyD;
+    std::vector<double> xyL;
+    //false when the systems changed since the last factorization
+    bool factorValid = false;
+    //the number of factorizations done
+    uint64_t factorCount = 0;
+
+    //the right hand sides and solutions, kept to avoid allocations
+    std::vector<double> rhs;
+    std::vector<double> rhsY;
+
+    //~ Function: node
+    //~ ----------------------------
+    //~ input: size_t i; the position of the pose in the window, 0 is the oldest
+    //~
+    //~ output: smootherNode &; the pose
+    smootherNode &node(size_t i);
+
+    //~ Function: factorize
+    //~ ----------------------------
+    //~ Factorizes the angle and the x and y systems of the current window
+    //~
+    //~ output: void
+    void factorize(void);
+
+    //~ Function: factorizeTridiagonal
+    //~ ----------------------------
+    //~ Calculates the LDLt factorization of a tridiagonal system built from
+    //~   the chain of samples, the fixes and the prior
+    //~
+    //~ input: double edgeWeight; the weight of a sample, double fixWeight; the
+    //~   weight of a fix
+    //~ inout: std::vector<double> &d; the returned inverse of the diagonal,
+    //~   std::vector<double> &l; the returned sub-diagonal
+    //~
+    //~ output: void
+    void factorizeTridiagonal(double edgeWeight, double fixWeight,
+      std::vector<double> &d, std::vector<double> &l);
+
+    //~ Function: solveTridiagonal
+    //~ ----------------------------
+    //~ Solves a factorized tridiagonal system in place
+    //~
+    //~ input: const std::vector<double> &d, const std::vector<double> &l; the
+    //~   factorization
+    //~ inout: std::vector<double> &b; the right hand side, returned solution
+    //~
+    //~ output: void
+    void solveTridiagonal(const std::vector<double> &d,
+      const std::vector<double> &l, std::vector<double> &b);
+};
+
+#endif // POSE_SMOOTHER_H
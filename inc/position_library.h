@@ -6,13 +6,37 @@
  * @Last modified time: 2022-02-13T00:13:21+01:00
  */
 
+#ifndef POSITION_LIBRARY_H
+#define POSITION_LIBRARY_H
+
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 ///////////////////////////////includes/////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 
+#include <span>
+#include <cmath>
 #include <array>
+#include <atomic>
+#include <cstdint>
+
+#ifndef STATIC_POSITION
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+//the acquisition tasks run on an eventLoop, see event_loop.h
+class eventLoop;
+struct sensorTask;
+#endif
+
+#include "wheel_calibration.h"
+#include "dead_reckoning_c.h"
+
+#ifdef FIXED_POINT_POSITION
+#include "fixed_point.h"
+#endif
 
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
@@ -35,6 +59,97 @@
 #define COORDS_SIZE                3
 //the value of pi
 #define PI                         3.141592654
+//the default acquisition frequency in Hz of the loops while the robot is idle
+#define IDLE_FREQ_HZ               2
+//the default yaw rate in rad/s under which the robot is considered still
+#define STILL_YAW_RATE             0.005
+//the default wheel speed in m/s under which the robot is considered still
+#define STILL_SPEED                0.005
+//the default number of still samples in a row before going idle
+#define STILL_SAMPLES              50
+//the integration schemes of the x and y update, see setIntegration
+#define INTEGRATION_EULER          0
+#define INTEGRATION_MIDPOINT       1
+#define INTEGRATION_ARC            2
+#define INTEGRATION_RK4            3
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////structs//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Struct: robotState
+//~ ----------------------------
+//~ Everything needed to resume the positioning where it stopped
+struct robotState{
+  //the coordinates as : [x, y, tetha]
+  std::array<float, COORDS_SIZE> coords;
+  //the last time in miliseconds when we updated the yaw angle
+  uint64_t lastAngleUpdateMS;
+  //the last time in miliseconds when we updated the x and y coordinates
+  uint64_t lastXYUpdateMS;
+  //true while the wheels are calibrated, then what the calibration learned
+  bool selfCalibration;
+  calibrationState calibration;
+};
+
+//~ Struct: gyroSample
+//~ ----------------------------
+//~ A gyrometer acquisition
+struct gyroSample{
+  //the yaw rate in rad/s
+  float yawRate;
+  //the time of the acquisition in miliseconds
+  uint32_t timestampMS;
+};
+
+//~ Struct: odometrySample
+//~ ----------------------------
+//~ An odometry acquisition
+struct odometrySample{
+  //the distance traveled by the 4 wheels as :
+  //[left_back, right_back, left_front, right_front]
+  std::array<float, 4> odometry;
+  //the time of the acquisition in miliseconds
+  uint32_t timestampMS;
+};
+
+//~ Struct: trajectoryPoint
+//~ ----------------------------
+//~ A timestamped pose of the trajectory
+struct trajectoryPoint{
+  //the time in miliseconds at which the pose was calculated
+  uint32_t timestampMS;
+  //the pose as [x, y, tetha]
+  std::array<float, COORDS_SIZE> pose;
+};
+
+//~ Type: poseSink
+//~ ----------------------------
+//~ A function receiving the pose after each x and y update, see
+//~   robotPosition::setPoseSink
+typedef void (*poseSink)(void *context, const trajectoryPoint &point);
+
+//~ Struct: rateStats
+//~ ----------------------------
+//~ The activity of the acquisition loops
+struct rateStats{
+  //the number of times each loop woke up
+  uint64_t gyroWakeups;
+  uint64_t odometryWakeups;
+  //the number of switches from full rate to idle rate and back
+  uint64_t toIdle;
+  uint64_t toActive;
+  //true if the loops currently run at the idle rate
+  bool idle;
+  //the number of sleeps of the loop threads that went to their end, then
+  //the total and maximum delay between that end and the wakeup, in
+  //nanoseconds
+  uint64_t sleeps;
+  uint64_t totalLateNs;
+  uint64_t maxLateNs;
+};
 
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
@@ -44,15 +159,24 @@
 
 //~ Class: robotPosition
 //~ ----------------------------
-//~ Contains the robot positionning functions and information
+//~ Contains the robot positionning functions and information.
+//~   Built with FIXED_POINT_POSITION, the pose is integrated in fixed point
+//~   (binary angle, Q15.16 positions, table sine and cosine) for targets
+//~   without a fast FPU: updateAngleFixed and updateXYFixed take integer
+//~   inputs and use no float, updateAngle and updateXY only convert their
+//~   float inputs, and coords is a float copy refreshed by the getters.
+//~   Built with STATIC_POSITION, only the integration is kept: no threads,
+//~   no loops and no iostream, staticPosition then drives it on a tick
 class robotPosition{
   public:
-    //contains the whole coordinates as : [x, y, tetha]
+    //contains the whole coordinates as : [x, y, tetha], in fixed point a
+    //copy of the pose only refreshed by getCoords and saveState
     std::array<float, COORDS_SIZE> coords = {0, 0, 0};
 
     robotPosition(void);
     ~robotPosition(void);
 
+#ifndef STATIC_POSITION
     //~ Function: updateCoordsThreads
     //~ ----------------------------
     //~ Creates two threads, one for updating the gyrometer data and one for
@@ -83,36 +207,284 @@ class robotPosition{
     //~ output: void
     void updateXYLoop(int odometryFreqHz);
 
+    //~ Function: updateCoordsTasks
+    //~ ----------------------------
+    //~ Spawns the gyrometer and the odometry acquisitions as two tasks of an
+    //~   event loop, the updates then run on the thread calling loop.run
+    //~   next to any other task of the loop. Unlike the threads, the two
+    //~   updates never run at the same time and their periods do not drift
+    //~
+    //~ input: eventLoop &loop; the loop to run the tasks on,
+    //~   int gyroFreqHz; the gyrometer refresh frequency in Hz,
+    //~   int odometryFreqHz; the odometry refresh frequency in Hz
+    //~
+    //~ output: void
+    void updateCoordsTasks(eventLoop &loop, int gyroFreqHz,
+      int odometryFreqHz);
+#endif
+
+    //~ Function: integrate
+    //~ ----------------------------
+    //~ Integrates recorded or buffered acquisitions in one call. The two
+    //~   streams are merged by timestamp and each sample goes through
+    //~   updateAngle or updateXY, under a single lock for the whole batch
+    //~
+    //~ input: std::span<const gyroSample> gyroSamples; the gyrometer samples,
+    //~   std::span<const odometrySample> odometrySamples; the odometry
+    //~   samples, both sorted by timestamp
+    //~ inout: std::span<trajectoryPoint> poses; if not empty, the pose after
+    //~   each sample is written there until it is full
+    //~
+    //~ output: size_t; the number of poses written
+    size_t integrate(std::span<const gyroSample> gyroSamples,
+      std::span<const odometrySample> odometrySamples,
+      std::span<trajectoryPoint> poses = {});
+
+    //~ Function: integrate
+    //~ ----------------------------
+    //~ The same integration over the structs of dead_reckoning_c.h, read and
+    //~   written in place in the caller's arrays
+    //~
+    //~ input: std::span<const deadReckoningGyroSample> gyroSamples; the
+    //~   gyrometer samples, std::span<const deadReckoningOdometrySample>
+    //~   odometrySamples; the odometry samples, both sorted by timestamp
+    //~ inout: std::span<deadReckoningPose> poses; if not empty, the pose after
+    //~   each sample is written there until it is full
+    //~
+    //~ output: size_t; the number of poses written
+    size_t integrate(std::span<const deadReckoningGyroSample> gyroSamples,
+      std::span<const deadReckoningOdometrySample> odometrySamples,
+      std::span<deadReckoningPose> poses = {});
+
+    //~ Function: getCoords
+    //~ ----------------------------
+    //~ Copies the coordinates, under the lock of the acquisition updates
+    //~
+    //~ inout: std::array<float, COORDS_SIZE> &coords; the returned
+    //~   [x, y, tetha]
+    //~
+    //~ output: void
+    void getCoords(std::array<float, COORDS_SIZE> &coords);
+
+    //~ Function: saveState
+    //~ ----------------------------
+    //~ Copies the positioning state, for example to checkpoint it. The copy
+    //~   is taken under the lock of the acquisition updates, so it can be
+    //~   called from another thread while they run
+    //~
+    //~ inout: robotState &state; the returned state
+    //~
+    //~ output: void
+    void saveState(robotState &state);
+
+    //~ Function: restoreState
+    //~ ----------------------------
+    //~ Resumes the positioning from a previously saved state
+    //~
+    //~ input: const robotState &state; the state to resume from
+    //~
+    //~ output: void
+    void restoreState(const robotState &state);
+
+    //~ Function: setIntegration
+    //~ ----------------------------
+    //~ Selects how the x and y update moves between two odometry samples.
+    //~   INTEGRATION_EULER, the default, goes straight along the last angle.
+    //~   The others integrate the angle with the mean of two yaw rates and
+    //~   move along: the mean angle of the interval for INTEGRATION_MIDPOINT,
+    //~   the exact circle arc for INTEGRATION_ARC, or the angle quadratic in
+    //~   time given by the interpolated yaw rates for INTEGRATION_RK4. It
+    //~   takes the lock of the acquisition updates, so it can be called while
+    //~   they run
+    //~
+    //~ input: int scheme; one of the INTEGRATION_ constants
+    //~
+    //~ output: int is 1 if suceess, -1 if the scheme is unknown or not
+    //~   available in fixed point
+    int setIntegration(int scheme);
+
+    //~ Function: setSelfCalibration
+    //~ ----------------------------
+    //~ Enables or disables the online calibration of the rear wheels. While
+    //~   enabled, each odometry interval is compared with the angle seen by
+    //~   the gyrometer and the estimated wheel scales correct the distances.
+    //~   Enabling it starts from perfect wheels, disabling it goes back to
+    //~   the raw distances. It takes the lock of the acquisition updates, so
+    //~   it can be called while they run
+    //~
+    //~ input: bool enabled; true to calibrate, float trackWidth; the nominal
+    //~   distance between the rear wheels in meters
+    //~
+    //~ output: void
+    void setSelfCalibration(bool enabled, float trackWidth = TRACK_WIDTH);
+
+    //~ Function: getCalibration
+    //~ ----------------------------
+    //~ Gets the current wheel calibration, under the lock of the
+    //~   acquisition updates
+    //~
+    //~ inout: float &leftScale, float &rightScale; the factors applied to the
+    //~   rear wheel distances, float &trackWidth; the effective track width
+    //~   in meters
+    //~
+    //~ output: void
+    void getCalibration(float &leftScale, float &rightScale,
+      float &trackWidth);
+
+    //~ Function: setPoseSink
+    //~ ----------------------------
+    //~ Gives the pose after every x and y update to a function, for example
+    //~   trajectoryEncoder::sink to compress the output. The function runs
+    //~   on the acquisition thread under the update lock, so it must be
+    //~   short and must not call the robotPosition back
+    //~
+    //~ input: poseSink sink; the function, NULL to remove it,
+    //~   void *context; given back to the function
+    //~
+    //~ output: void
+    void setPoseSink(poseSink sink, void *context);
+
+#ifndef STATIC_POSITION
+    //~ Function: setAdaptiveRate
+    //~ ----------------------------
+    //~ Enables the adaptive rate: once the gyrometer and the odometry have
+    //~   shown the robot still for a number of samples in a row, both loops
+    //~   run at the idle frequency. The first sample showing motion brings
+    //~   them back to their full frequency and wakes up the other loop. The
+    //~   sensors are only read when a loop wakes up, so the motion is seen
+    //~   up to one idle period (1/idleFreqHz, 500ms by default) after it
+    //~   started. It can be called while the loops run
+    //~
+    //~ input: int idleFreqHz; the frequency of the loops while idle,
+    //~   float stillYawRate; the yaw rate in rad/s under which the robot is
+    //~   still, float stillSpeed; the wheel speed in m/s under which the robot
+    //~   is still, int stillSamples; the number of still samples in a row
+    //~   before going idle
+    //~
+    //~ output: void
+    void setAdaptiveRate(int idleFreqHz = IDLE_FREQ_HZ,
+      float stillYawRate = STILL_YAW_RATE, float stillSpeed = STILL_SPEED,
+      int stillSamples = STILL_SAMPLES);
+
+    //~ Function: getRateStats
+    //~ ----------------------------
+    //~ Gets the activity of the acquisition loops
+    //~
+    //~ inout: rateStats &stats; the returned statistics
+    //~
+    //~ output: void
+    void getRateStats(rateStats &stats);
+
+    //~ Function: stopLoops
+    //~ ----------------------------
+    //~ Makes the acquisition loops return after their current iteration.
+    //~   If updateCoordsTasks was used, it also stops the event loop the
+    //~   tasks run on, so its run returns without waiting for their next
+    //~   deadline
+    //~
+    //~ output: void
+    void stopLoops(void);
+#endif
+
   private:
+    //the tick driven integrator of the static build
+    template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+    friend class staticPosition;
 
     //this is the last time in miliseconds when we updated the yaw angle
     uint64_t lastAngleUpdateMS = 0;
     //this is the last time in miliseconds when we updated the x and y coordinates
     uint64_t lastXYUpdateMS = 0;
 
+    //the integration scheme, see setIntegration
+    int integration = INTEGRATION_EULER;
+    //the last yaw rate integrated, then the angle and the yaw rate at the
+    //last x and y update, for the schemes other than euler. There is no
+    //last yaw rate before the first sample, it is then seeded from it
+    bool hasYawRate = false;
+    float lastYawRate = 0;
+    float lastXYTetha = 0;
+    float lastXYYawRate = 0;
+
+    //true while the wheels are calibrated, see setSelfCalibration
+    bool selfCalibration = false;
+    wheelCalibrator calibrator;
+    //the angle seen by the gyrometer since the last x and y update, the
+    //two updates hold stateMutex
+    float calibrationTetha = 0;
+    //the factors applied to the rear wheel distances
+    float leftScale = 1;
+    float rightScale = 1;
+
+    //the function receiving the poses and its context, see setPoseSink
+    poseSink sink = NULL;
+    void *sinkContext = NULL;
+
+#ifdef FIXED_POINT_POSITION
+    //the pose that is integrated, coords is only refreshed from it
+    fixedPose fixedCoords = {0, 0, 0};
+    //leftScale and rightScale in Q15.16
+    fixedQ16 fixedLeftScale = 1 << FIXED_POSITION_BITS;
+    fixedQ16 fixedRightScale = 1 << FIXED_POSITION_BITS;
+#endif
+
+#ifndef STATIC_POSITION
+    //false once the loops must return
+    std::atomic<bool> running{true};
+    //true once setAdaptiveRate was called, set after the configuration
+    std::atomic<bool> adaptiveRate{false};
+    //the adaptive rate configuration, see setAdaptiveRate, written while
+    //the loops read it
+    std::atomic<int> idleFreqHz{IDLE_FREQ_HZ};
+    std::atomic<float> stillYawRate{STILL_YAW_RATE};
+    std::atomic<float> stillSpeed{STILL_SPEED};
+    std::atomic<int> stillSamplesNeeded{STILL_SAMPLES};
+    //the number of still samples in a row, from both loops
+    std::atomic<int> stillSamples{0};
+    //true while the loops run at the idle rate
+    std::atomic<bool> idle{false};
+    //the loop activity counters
+    std::atomic<uint64_t> gyroWakeups{0};
+    std::atomic<uint64_t> odometryWakeups{0};
+    std::atomic<uint64_t> toIdle{0};
+    std::atomic<uint64_t> toActive{0};
+    //the lateness of the loop threads sleeps, under rateMutex
+    uint64_t sleeps = 0;
+    uint64_t totalLateNs = 0;
+    uint64_t maxLateNs = 0;
+    //the event loop of updateCoordsTasks, stopped by stopLoops
+    std::atomic<eventLoop *> tasksLoop{NULL};
+    //wakes up the loops sleeping at the idle rate when the robot moves
+    std::mutex rateMutex;
+    std::condition_variable rateChanged;
+    //held by the acquisition updates and by saveState and restoreState, so
+    //a saved state is never torn between two updates
+    std::mutex stateMutex;
+#endif
+
     //~ Function: updateCoords
     //~ ----------------------------
     //~ From the odometry and yaw rate data, it updates the yaw angle,
     //~   x and y position
     //~
-    //~ input: std::array<float, 4> odometry; the odometry of the 4 wheels,
+    //~ input: const std::array<float, 4> &odometry; the odometry of the 4 wheels,
     //~   uint32_t odometryTSMS; the time since the last odometry was took,
     //~   float yawRate; the yaw rate in rad/s, uint32_t yawRateTSMS; the
     //~   time since the last yaw rate was took.
     //~
     //~ output: void
-    void updateCoords(std::array<float, 4> odometry, uint32_t odometryTSMS,
+    void updateCoords(const std::array<float, 4> &odometry, uint32_t odometryTSMS,
       float yawRate, uint32_t yawRateTSMS);
 
     //~ Function: updateXY
     //~ ----------------------------
     //~ From the odometry data, it updates the x and y position
     //~
-    //~ input: std::array<float, 4> odometry; the odometry of the 4 wheels,
+    //~ input: const std::array<float, 4> &odometry; the odometry of the 4 wheels,
     //~   uint32_t odometryTSMS; the time since the last odometry was took.
     //~
     //~ output: void
-    void updateXY(std::array<float, 4> odometry, uint32_t odometryTSMS);
+    void updateXY(const std::array<float, 4> &odometry, uint32_t odometryTSMS);
 
     //~ Function: updateAngle
     //~ ----------------------------
@@ -124,15 +496,50 @@ class robotPosition{
     //~ output: void
     void updateAngle(float yawRate, uint32_t yawRateTSMS);
 
+#ifdef FIXED_POINT_POSITION
+    //~ Function: updateAngleFixed
+    //~ ----------------------------
+    //~ The fixed point update of the angle, without any float unless the
+    //~   self calibration is enabled. A gyrometer giving an integer rate
+    //~   calls it directly
+    //~
+    //~ input: int64_t yawRate; the yaw rate in binary angle units per second,
+    //~   uint32_t yawRateTSMS; the time since the last yaw rate was took
+    //~
+    //~ output: void
+    void updateAngleFixed(int64_t yawRate, uint32_t yawRateTSMS);
+
+    //~ Function: updateXYFixed
+    //~ ----------------------------
+    //~ The fixed point update of x and y, without any float unless the self
+    //~   calibration is enabled. An odometry giving integer distances calls
+    //~   it directly
+    //~
+    //~ input: const std::array<fixedQ16, 4> &odometry; the odometry of the 4
+    //~   wheels in Q15.16, uint32_t odometryTSMS; the time since the last
+    //~   odometry was took
+    //~
+    //~ output: void
+    void updateXYFixed(const std::array<fixedQ16, 4> &odometry,
+      uint32_t odometryTSMS);
+#endif
+
+    //~ Function: floatCoords
+    //~ ----------------------------
+    //~ Refreshes coords from the fixed point pose in that mode
+    //~
+    //~ output: const std::array<float, COORDS_SIZE> &; coords
+    const std::array<float, COORDS_SIZE> &floatCoords(void);
+
     //~ Function: calculateDeltaDist
     //~ ----------------------------
     //~ Calculates the variation in distance from the wheel odometry
     //~
-    //~ input: std::array<float, 4> odometry; the wheel odometry array organized
+    //~ input: const std::array<float, 4> &odometry; the wheel odometry array organized
     //~   as following : [left_back, right_back, left_front, right_front]
     //~
     //~ output: float; distance traveled by the point in between the two rear wheels
-    float calculateDeltaDist(std::array<float, 4> odometry);
+    float calculateDeltaDist(const std::array<float, 4> &odometry);
 
     //~ Function: calculateDeltaTetha
     //~ ----------------------------
@@ -169,13 +576,231 @@ class robotPosition{
     //~ ----------------------------
     //~ Calculates the current x and y on the absolute coordinate system
     //~
-    //~ input: std::array<float, XY_COORDS_SIZE> deltaCoords; x and y shift from
-    //~   the last position, std::array<float, XY_COORDS_SIZE> lastCoords; x and y
-    //~   of the last position
+    //~ input: const std::array<float, XY_COORDS_SIZE> &deltaCoords; x and y
+    //~   shift from the last position,
+    //~   const std::array<float, XY_COORDS_SIZE> &lastCoords; x and y of the last
+    //~   position
     //~
     //~ output: std::array<float, XY_COORDS_SIZE>; x and y on the absolute
     //~   coordinate system as following: [x, y]
     std::array<float, XY_COORDS_SIZE> getAbsCoords(
-      std::array<float, XY_COORDS_SIZE> deltaCoords,
-      std::array<float, XY_COORDS_SIZE> lastCoords);
+      const std::array<float, XY_COORDS_SIZE> &deltaCoords,
+      const std::array<float, XY_COORDS_SIZE> &lastCoords);
+
+    //~ Function: integrateXY
+    //~ ----------------------------
+    //~ Moves a pose with the selected scheme other than euler, from the angle
+    //~   at the last x and y update to its current angle
+    //~
+    //~ inout: std::array<float, COORDS_SIZE> &pose; the pose updated
+    //~ input: float deltaDist; the distance traveled, uint32_t deltaMS; the
+    //~   time since the last x and y update
+    //~
+    //~ output: void
+    void integrateXY(std::array<float, COORDS_SIZE> &pose, float deltaDist,
+      uint32_t deltaMS);
+
+    //~ Function: integrateSamples
+    //~ ----------------------------
+    //~ The merge behind both integrate, over the library or the C structs
+    //~
+    //~ input: std::span<const gyroType> gyroSamples; the gyrometer samples,
+    //~   std::span<const odometryType> odometrySamples; the odometry samples,
+    //~   both sorted by timestamp
+    //~ inout: std::span<poseType> poses; if not empty, the pose after each
+    //~   sample is written there until it is full
+    //~
+    //~ output: size_t; the number of poses written
+    template <typename gyroType, typename odometryType, typename poseType>
+    size_t integrateSamples(std::span<const gyroType> gyroSamples,
+      std::span<const odometryType> odometrySamples,
+      std::span<poseType> poses);
+
+    //~ Function: calibrate
+    //~ ----------------------------
+    //~ Gives an odometry interval and the angle seen by the gyrometer over it
+    //~   to the calibration, then takes the new wheel scales
+    //~
+    //~ input: const std::array<float, 4> &odometry; the raw odometry
+    //~
+    //~ output: void
+    void calibrate(const std::array<float, 4> &odometry);
+
+    //~ Function: takeScales
+    //~ ----------------------------
+    //~ Takes the wheel scales of the calibrator
+    //~
+    //~ output: void
+    void takeScales(void);
+
+    //~ Function: emitPose
+    //~ ----------------------------
+    //~ Gives the current pose to the sink if there is one
+    //~
+    //~ input: uint32_t timestampMS; the time of the pose
+    //~
+    //~ output: void
+    void emitPose(uint32_t timestampMS);
+
+#ifndef STATIC_POSITION
+    //~ Function: updateMotion
+    //~ ----------------------------
+    //~ Switches between full and idle rate from the last sample of a loop
+    //~
+    //~ input: bool still; true if the sample shows the robot still
+    //~
+    //~ output: void
+    void updateMotion(bool still);
+
+    //~ Function: loopPeriodMS
+    //~ ----------------------------
+    //~ Gives the period of a loop for the current rate
+    //~
+    //~ input: int freqHz; the full frequency of the loop in Hz
+    //~
+    //~ output: int; the period of the loop in miliseconds
+    int loopPeriodMS(int freqHz);
+
+    //~ Function: waitPeriod
+    //~ ----------------------------
+    //~ Sleeps until the next iteration of a loop. With the adaptive rate, an
+    //~   idle sleep is cut short when the robot starts moving. The lateness
+    //~   of the sleeps that go to their end is counted in the rate stats
+    //~
+    //~ input: int sleepMS; the time to sleep in miliseconds
+    //~
+    //~ output: void
+    void waitPeriod(int sleepMS);
+
+    //~ Function: countLateness
+    //~ ----------------------------
+    //~ Adds the lateness of a sleep to the rate stats, rateMutex held
+    //~
+    //~ input: std::chrono::steady_clock::time_point end; when the sleep
+    //~   should have ended
+    //~
+    //~ output: void
+    void countLateness(std::chrono::steady_clock::time_point end);
+
+    //~ Function: updateAngleTask
+    //~ ----------------------------
+    //~ The task that updates the angle from the gyrometer, see updateAngleLoop
+    //~
+    //~ input: eventLoop &loop; the loop it runs on,
+    //~   int gyroFreqHz; the gyrometer refresh frequency in Hz
+    //~
+    //~ output: sensorTask; the task to spawn
+    sensorTask updateAngleTask(eventLoop &loop, int gyroFreqHz);
+
+    //~ Function: updateXYTask
+    //~ ----------------------------
+    //~ The task that updates the x and y coordinates from the odometry, see
+    //~   updateXYLoop
+    //~
+    //~ input: eventLoop &loop; the loop it runs on,
+    //~   int odometryFreqHz; the odometry refresh frequency in Hz
+    //~
+    //~ output: sensorTask; the task to spawn
+    sensorTask updateXYTask(eventLoop &loop, int odometryFreqHz);
+
+    //~ Function: nextDeadline
+    //~ ----------------------------
+    //~ Gives the next wakeup of a task, skipping the periods already missed
+    //~
+    //~ input: uint64_t deadlineNs; the last wakeup, int freqHz; the full
+    //~   frequency of the task in Hz
+    //~
+    //~ output: uint64_t; the next wakeup, see eventLoop::nowNs
+    uint64_t nextDeadline(uint64_t deadlineNs, int freqHz);
+#endif
 };
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+/////////////////////////////inline methods/////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the per-sample math, inline so that the acquisition loops, integrate and
+//the C interface all run the same code without a call per helper
+
+//~ Function: calculateDeltaDist
+//~ ----------------------------
+//~ Calculates the variation in distance from the wheel odometry
+//~
+//~ input: const std::array<float, 4> &odometry; the wheel odometry array organized
+//~   as following : [left_back, right_back, left_front, right_front]
+//~
+//~ output: float; distance draveled by the point in between the two rear wheels
+inline float robotPosition::calculateDeltaDist(
+  const std::array<float, 4> &odometry){
+
+  //the scales stay at 1 without the self calibration
+  return MEAN(leftScale*odometry[0], rightScale*odometry[1]);
+}// end function calculateDeltaDist
+
+//~ Function: calculateDeltaTetha
+//~ ----------------------------
+//~ Calculates the variation of the direction with the yawRate and time
+//~
+//~ input: float yawRate; the yaw rate in rad/s, uint32_t deltaTMs; the time
+//~   difference between the last yawRate acquisition and the new one
+//~
+//~ output: float; angle difference between the last position and the new one
+inline float robotPosition::calculateDeltaTetha(float yawRate,
+  uint32_t deltaTMs){
+
+  float deltaTetha = (float) deltaTMs/1000*yawRate;
+  //fmod gives back the angle unchanged under a turn, it is only paid over
+  return fabs(deltaTetha) < 2*PI ? deltaTetha : fmod(deltaTetha, 2*PI);
+}// end function calculateDeltaTetha
+
+//~ Function: calculateTetha
+//~ ----------------------------
+//~ Calculates the new angle between our x axis and the robot direction
+//~
+//~ input: float deltaTetha; the angle variation in rads, float lastTetha;
+//~   the angle between x axis and our robot at the last positon
+//~
+//~ output: float; angle between x axis and our robot's current position
+inline float robotPosition::calculateTetha(float deltaTetha,
+  float lastTetha){
+
+  float tetha = deltaTetha + lastTetha;
+  return fabs(tetha) < 2*PI ? tetha : fmod(tetha, 2*PI);
+}// end function calculateTetha
+
+//~ Function: calculateDeltaCoords
+//~ ----------------------------
+//~ Calculates the x and y shift on the abolute coordinate system
+//~
+//~ input: float dist; distance traveled, float tetha;
+//~   the angle between x axis and our robot at the current positon
+//~
+//~ output: std::array<float, XY_COORDS_SIZE>; the x and y shift as following:
+//~   [x, y]
+inline std::array<float, XY_COORDS_SIZE>
+  robotPosition::calculateDeltaCoords(float dist, float tetha){
+
+  return {(float) (dist*cos(tetha)), (float) (dist*sin(tetha))};
+}// end function calculateDeltaCoords
+
+//~ Function: getAbsCoords
+//~ ----------------------------
+//~ Calculates the current x and y on the absolute coordinate system
+//~
+//~ input: const std::array<float, XY_COORDS_SIZE> &deltaCoords; x and y
+//~   shift from the last position,
+//~   const std::array<float, XY_COORDS_SIZE> &lastCoords; x and y of the last
+//~   position
+//~
+//~ output: std::array<float, XY_COORDS_SIZE>; x and y on the absolute
+//~   coordinate system as following: [x, y]
+inline std::array<float, XY_COORDS_SIZE> robotPosition::getAbsCoords(
+  const std::array<float, XY_COORDS_SIZE> &deltaCoords,
+  const std::array<float, XY_COORDS_SIZE> &lastCoords){
+
+  return {lastCoords[0] + deltaCoords[0], lastCoords[1] + deltaCoords[1]};
+}// end function getAbsCoords
+
+#endif // POSITION_LIBRARY_H
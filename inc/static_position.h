@@ -0,0 +1,314 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T16:27:12+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: static_position.h
+ * @Last modified time: 2026-10-19T16:27:12+02:00
+ */
+
+#ifndef STATIC_POSITION_H
+#define STATIC_POSITION_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "position_library.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the default number of gyrometer samples waiting for the next tick
+#define STATIC_GYRO_SAMPLES        16
+//the default number of odometry samples waiting for the next tick
+#define STATIC_ODOMETRY_SAMPLES    16
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////class///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Class: staticPosition
+//~ ----------------------------
+//~ Runs the robotPosition integration on an external tick instead of its
+//~   own threads. The sensor drivers (or their interrupts) push the samples
+//~   in fixed size queues and the tick integrates them in timestamp order.
+//~   Nothing is allocated and nothing throws, the queue sizes are template
+//~   parameters, powers of two. One producer per queue and one tick caller
+//~   may run concurrently.
+template <size_t GYRO_SAMPLES = STATIC_GYRO_SAMPLES,
+  size_t ODOMETRY_SAMPLES = STATIC_ODOMETRY_SAMPLES>
+class staticPosition{
+  static_assert(GYRO_SAMPLES > 0 && (GYRO_SAMPLES & (GYRO_SAMPLES - 1)) == 0,
+    "GYRO_SAMPLES must be a power of two");
+  static_assert(ODOMETRY_SAMPLES > 0 &&
+    (ODOMETRY_SAMPLES & (ODOMETRY_SAMPLES - 1)) == 0,
+    "ODOMETRY_SAMPLES must be a power of two");
+
+  public:
+    staticPosition(void) noexcept;
+    ~staticPosition(void);
+
+    //~ Function: pushGyrometer
+    //~ ----------------------------
+    //~ Queues a gyrometer sample for the next tick
+    //~
+    //~ input: float yawRate; the yaw rate in rad/s, uint32_t timestampMS; the
+    //~   time of the acquisition in miliseconds
+    //~
+    //~ output: int is 1 if suceess, -1 if the queue is full and the sample lost
+    int pushGyrometer(float yawRate, uint32_t timestampMS) noexcept;
+
+    //~ Function: pushOdometry
+    //~ ----------------------------
+    //~ Queues an odometry sample for the next tick
+    //~
+    //~ input: const std::array<float, 4> &odometry; the odometry of the 4
+    //~   wheels, uint32_t timestampMS; the time of the acquisition in
+    //~   miliseconds
+    //~
+    //~ output: int is 1 if suceess, -1 if the queue is full and the sample lost
+    int pushOdometry(const std::array<float, 4> &odometry,
+      uint32_t timestampMS) noexcept;
+
+    //~ Function: tick
+    //~ ----------------------------
+    //~ Integrates the queued samples, oldest first whatever their sensor
+    //~
+    //~ input: size_t maxSamples; the maximum number of samples integrated, it
+    //~   bounds the time spent in the tick
+    //~
+    //~ output: size_t; the number of samples integrated
+    size_t tick(size_t maxSamples = GYRO_SAMPLES + ODOMETRY_SAMPLES) noexcept;
+
+    //~ Function: getCoords
+    //~ ----------------------------
+    //~ inout: std::array<float, COORDS_SIZE> &coords; the returned [x, y, tetha]
+    //~
+    //~ output: void
+    void getCoords(std::array<float, COORDS_SIZE> &coords) noexcept;
+
+    //~ Function: saveState
+    //~ ----------------------------
+    //~ Copies the positioning state, for example to checkpoint it
+    //~
+    //~ inout: robotState &state; the returned state
+    //~
+    //~ output: void
+    void saveState(robotState &state) noexcept;
+
+    //~ Function: restoreState
+    //~ ----------------------------
+    //~ Resumes the positioning from a previously saved state
+    //~
+    //~ input: const robotState &state; the state to resume from
+    //~
+    //~ output: void
+    void restoreState(const robotState &state) noexcept;
+
+    //~ Function: droppedSamples
+    //~ ----------------------------
+    //~ output: uint32_t; the number of samples lost because a queue was full
+    uint32_t droppedSamples(void) noexcept;
+
+  private:
+
+    //the integrator
+    robotPosition position;
+
+    //the queues, the indexes run freely and are masked on access
+    std::array<gyroSample, GYRO_SAMPLES> gyroSamples;
+    std::array<odometrySample, ODOMETRY_SAMPLES> odometrySamples;
+    std::atomic<uint32_t> gyroWrite{0};
+    std::atomic<uint32_t> gyroRead{0};
+    std::atomic<uint32_t> odometryWrite{0};
+    std::atomic<uint32_t> odometryRead{0};
+    //the number of samples lost
+    std::atomic<uint32_t> dropped{0};
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////constructor destructor///////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::staticPosition(void)
+  noexcept{
+}
+
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::~staticPosition(void){
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////public methods///////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: pushGyrometer
+//~ ----------------------------
+//~ Queues a gyrometer sample for the next tick
+//~
+//~ input: float yawRate; the yaw rate in rad/s, uint32_t timestampMS; the
+//~   time of the acquisition in miliseconds
+//~
+//~ output: int is 1 if suceess, -1 if the queue is full and the sample lost
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+int staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::pushGyrometer(
+  float yawRate, uint32_t timestampMS) noexcept{
+
+  uint32_t write = gyroWrite.load(std::memory_order_relaxed);
+  if (write - gyroRead.load(std::memory_order_acquire) >= GYRO_SAMPLES){
+    dropped++;
+    return -1;
+  }
+
+  gyroSamples[write & (GYRO_SAMPLES - 1)] = {yawRate, timestampMS};
+  //publish the sample once it is written
+  gyroWrite.store(write + 1, std::memory_order_release);
+
+  return 1;
+}// end function pushGyrometer
+
+//~ Function: pushOdometry
+//~ ----------------------------
+//~ Queues an odometry sample for the next tick
+//~
+//~ input: const std::array<float, 4> &odometry; the odometry of the 4
+//~   wheels, uint32_t timestampMS; the time of the acquisition in
+//~   miliseconds
+//~
+//~ output: int is 1 if suceess, -1 if the queue is full and the sample lost
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+int staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::pushOdometry(
+  const std::array<float, 4> &odometry, uint32_t timestampMS) noexcept{
+
+  uint32_t write = odometryWrite.load(std::memory_order_relaxed);
+  if (write - odometryRead.load(std::memory_order_acquire) >=
+    ODOMETRY_SAMPLES){
+
+    dropped++;
+    return -1;
+  }
+
+  odometrySamples[write & (ODOMETRY_SAMPLES - 1)] = {odometry, timestampMS};
+  //publish the sample once it is written
+  odometryWrite.store(write + 1, std::memory_order_release);
+
+  return 1;
+}// end function pushOdometry
+
+//~ Function: tick
+//~ ----------------------------
+//~ Integrates the queued samples, oldest first whatever their sensor
+//~
+//~ input: size_t maxSamples; the maximum number of samples integrated, it
+//~   bounds the time spent in the tick
+//~
+//~ output: size_t; the number of samples integrated
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+size_t staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::tick(
+  size_t maxSamples) noexcept{
+
+  uint32_t gyroNext = gyroRead.load(std::memory_order_relaxed);
+  uint32_t odometryNext = odometryRead.load(std::memory_order_relaxed);
+  size_t integrated = 0;
+
+  while (integrated < maxSamples){
+    bool hasGyro = gyroNext != gyroWrite.load(std::memory_order_acquire);
+    bool hasOdometry =
+      odometryNext != odometryWrite.load(std::memory_order_acquire);
+    if (!hasGyro && !hasOdometry){
+      break;
+    }
+
+    const gyroSample &gyro = gyroSamples[gyroNext & (GYRO_SAMPLES - 1)];
+    const odometrySample &odometry =
+      odometrySamples[odometryNext & (ODOMETRY_SAMPLES - 1)];
+    //the oldest sample first, the difference survives the timestamp wrap
+    if (hasGyro && (!hasOdometry ||
+      (int32_t) (gyro.timestampMS - odometry.timestampMS) <= 0)){
+
+      position.updateAngle(gyro.yawRate,
+        gyro.timestampMS - position.lastAngleUpdateMS);
+      position.lastAngleUpdateMS = gyro.timestampMS;
+      gyroRead.store(++gyroNext, std::memory_order_release);
+    }
+    else{
+      position.updateXY(odometry.odometry,
+        odometry.timestampMS - position.lastXYUpdateMS);
+      position.lastXYUpdateMS = odometry.timestampMS;
+      position.emitPose(odometry.timestampMS);
+      odometryRead.store(++odometryNext, std::memory_order_release);
+    }
+    integrated++;
+  }
+
+  return integrated;
+}// end function tick
+
+//~ Function: getCoords
+//~ ----------------------------
+//~ inout: std::array<float, COORDS_SIZE> &coords; the returned [x, y, tetha]
+//~
+//~ output: void
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+void staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::getCoords(
+  std::array<float, COORDS_SIZE> &coords) noexcept{
+
+  position.getCoords(coords);
+}// end function getCoords
+
+//~ Function: saveState
+//~ ----------------------------
+//~ Copies the positioning state, for example to checkpoint it
+//~
+//~ inout: robotState &state; the returned state
+//~
+//~ output: void
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+void staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::saveState(
+  robotState &state) noexcept{
+
+  position.saveState(state);
+}// end function saveState
+
+//~ Function: restoreState
+//~ ----------------------------
+//~ Resumes the positioning from a previously saved state
+//~
+//~ input: const robotState &state; the state to resume from
+//~
+//~ output: void
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+void staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::restoreState(
+  const robotState &state) noexcept{
+
+  position.restoreState(state);
+}// end function restoreState
+
+//~ Function: droppedSamples
+//~ ----------------------------
+//~ output: uint32_t; the number of samples lost because a queue was full
+template <size_t GYRO_SAMPLES, size_t ODOMETRY_SAMPLES>
+uint32_t staticPosition<GYRO_SAMPLES, ODOMETRY_SAMPLES>::droppedSamples(void)
+  noexcept{
+
+  return dropped;
+}// end function droppedSamples
+
+#endif // STATIC_POSITION_H
@@ -0,0 +1,223 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T13:02:47+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: trajectory_compression.h
+ * @Last modified time: 2026-10-19T13:02:47+02:00
+ */
+
+#ifndef TRAJECTORY_COMPRESSION_H
+#define TRAJECTORY_COMPRESSION_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "position_library.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the default maximum number of poses between two key poses
+#define COMPRESSION_DEFAULT_WINDOW 64
+//the size of the stream header: the x and y step then the angle step
+#define COMPRESSION_HEADER_SIZE    (2*sizeof(float))
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////class///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Class: trajectoryEncoder
+//~ ----------------------------
+//~ Compresses a stream of poses on the fly. Only key poses are kept, such
+//~   that interpolating linearly in time between two key poses never moves
+//~   more than the maximum errors away from the dropped poses. Key poses are
+//~   quantized and stored as varint encoded differences.
+class trajectoryEncoder{
+  public:
+
+    //~ Function: trajectoryEncoder
+    //~ ----------------------------
+    //~ Constructor
+    //~
+    //~ input: float maxXYError; the maximum position error in meters,
+    //~   float maxTethaError; the maximum angle error in rads,
+    //~   size_t windowSize; the maximum number of poses between two key poses,
+    //~   it bounds the work done for each pose
+    trajectoryEncoder(float maxXYError, float maxTethaError,
+      size_t windowSize = COMPRESSION_DEFAULT_WINDOW);
+    ~trajectoryEncoder(void);
+
+    //~ Function: addPose
+    //~ ----------------------------
+    //~ Adds the next pose of the trajectory, timestamps must not decrease
+    //~
+    //~ input: uint32_t timestampMS; the time of the pose in miliseconds,
+    //~   std::array<float, COORDS_SIZE> pose; the pose as [x, y, tetha]
+    //~
+    //~ output: void
+    void addPose(uint32_t timestampMS, std::array<float, COORDS_SIZE> pose);
+
+    //~ Function: flush
+    //~ ----------------------------
+    //~ Writes the last pose received as a key pose, to call at the end of the
+    //~   trajectory
+    //~
+    //~ output: void
+    void flush(void);
+
+    //~ Function: getBytes
+    //~ ----------------------------
+    //~ output: const std::vector<uint8_t> &; the encoded stream so far
+    const std::vector<uint8_t> &getBytes(void);
+
+    //~ Function: poses
+    //~ ----------------------------
+    //~ output: uint64_t; the number of poses received
+    uint64_t poses(void);
+
+    //~ Function: keyPoses
+    //~ ----------------------------
+    //~ output: uint64_t; the number of key poses written
+    uint64_t keyPoses(void);
+
+    //~ Function: sink
+    //~ ----------------------------
+    //~ The poseSink that compresses the output of a robotPosition:
+    //~   robot_position.setPoseSink(trajectoryEncoder::sink, &encoder)
+    //~
+    //~ input: void *encoder; the trajectoryEncoder,
+    //~   const trajectoryPoint &point; the pose to add
+    //~
+    //~ output: void
+    static void sink(void *encoder, const trajectoryPoint &point);
+
+  private:
+
+    //the maximum position and angle errors
+    float maxXY;
+    float maxTetha;
+    //the quantization steps of the positions and of the angles
+    float xyStep;
+    float tethaStep;
+    //the maximum number of poses between two key poses
+    size_t window;
+
+    //the poses received since the last key pose
+    std::vector<trajectoryPoint> pending;
+    //the last key pose, as written
+    trajectoryPoint anchor;
+    //the last key pose quantized: [timestamp, x, y, tetha]
+    std::array<int64_t, COORDS_SIZE + 1> anchorQ;
+    //false until the first key pose is written
+    bool hasAnchor = false;
+
+    //the encoded stream
+    std::vector<uint8_t> bytes;
+    //the counters
+    uint64_t poseCount = 0;
+    uint64_t keyCount = 0;
+
+    //~ Function: quantize
+    //~ ----------------------------
+    //~ Quantizes a pose to the steps of the stream
+    //~
+    //~ input: const trajectoryPoint &point; the pose
+    //~ inout: std::array<int64_t, COORDS_SIZE + 1> &quantized; the returned
+    //~   [timestamp, x, y, tetha] in steps, trajectoryPoint &dequantized; the
+    //~   pose as the decoder will read it
+    //~
+    //~ output: void
+    void quantize(const trajectoryPoint &point,
+      std::array<int64_t, COORDS_SIZE + 1> &quantized,
+      trajectoryPoint &dequantized);
+
+    //~ Function: segmentFits
+    //~ ----------------------------
+    //~ Checks that all the pending poses are close enough to the segment from
+    //~   the last key pose to a candidate key pose
+    //~
+    //~ input: const trajectoryPoint &end; the candidate key pose, dequantized
+    //~
+    //~ output: bool; true if no pending pose is farther than the errors
+    bool segmentFits(const trajectoryPoint &end);
+
+    //~ Function: writeKeyPose
+    //~ ----------------------------
+    //~ Writes a key pose at the end of the stream
+    //~
+    //~ input: const trajectoryPoint &point; the key pose
+    //~
+    //~ output: void
+    void writeKeyPose(const trajectoryPoint &point);
+
+    //~ Function: writeVarint
+    //~ ----------------------------
+    //~ Writes a signed integer on as few bytes as possible, 7 bits per byte
+    //~
+    //~ input: int64_t value; the integer
+    //~
+    //~ output: void
+    void writeVarint(int64_t value);
+};
+
+//~ Class: trajectoryDecoder
+//~ ----------------------------
+//~ Reads back the key poses of a stream written by trajectoryEncoder and
+//~   interpolates the poses in between
+class trajectoryDecoder{
+  public:
+    trajectoryDecoder(void);
+    ~trajectoryDecoder(void);
+
+    //~ Function: decode
+    //~ ----------------------------
+    //~ Decodes all the key poses of a stream
+    //~
+    //~ input: const uint8_t *data; the stream, size_t size; its size in bytes
+    //~ inout: std::vector<trajectoryPoint> &keyPoints; cleared then filled
+    //~   with the key poses
+    //~
+    //~ output: int is 1 if suceess, -1 if the stream is truncated or invalid
+    int decode(const uint8_t *data, size_t size,
+      std::vector<trajectoryPoint> &keyPoints);
+
+    //~ Function: getPose
+    //~ ----------------------------
+    //~ Interpolates the pose at a given time between the key poses
+    //~
+    //~ input: const std::vector<trajectoryPoint> &keyPoints; the decoded key
+    //~   poses, uint32_t timestampMS; the time of the pose wanted
+    //~ inout: std::array<float, COORDS_SIZE> &pose; the returned pose
+    //~
+    //~ output: int is 1 if suceess, -1 if the time is outside the trajectory
+    int getPose(const std::vector<trajectoryPoint> &keyPoints,
+      uint32_t timestampMS, std::array<float, COORDS_SIZE> &pose);
+
+  private:
+
+    //~ Function: readVarint
+    //~ ----------------------------
+    //~ Reads a signed integer written by writeVarint
+    //~
+    //~ input: const uint8_t *data, size_t size; the stream
+    //~ inout: size_t &offset; the position in the stream, moved after the
+    //~   integer, int64_t &value; the returned integer
+    //~
+    //~ output: int is 1 if suceess, -1 if the stream is truncated
+    int readVarint(const uint8_t *data, size_t size, size_t &offset,
+      int64_t &value);
+};
+
+#endif // TRAJECTORY_COMPRESSION_H
@@ -0,0 +1,160 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T18:36:52+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: wheel_calibration.h
+ * @Last modified time: 2026-10-19T18:36:52+02:00
+ */
+
+#ifndef WHEEL_CALIBRATION_H
+#define WHEEL_CALIBRATION_H
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////includes/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the default distance in meters between the two rear wheels
+#define TRACK_WIDTH                0.5
+//the default forgetting factor, the estimate follows the tire wear over
+//about 1/(1 - factor) samples
+#define CALIBRATION_FORGETTING     0.99995
+//the initial variance of the estimates
+#define CALIBRATION_VARIANCE       10000.0
+//the wheel distance in meters under which a sample is not used
+#define CALIBRATION_MIN_DIST       0.0001
+//the maximum correction of a wheel scale, 0.2 for +/-20%
+#define CALIBRATION_MAX_CORRECTION 0.2
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////structs//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Struct: calibrationState
+//~ ----------------------------
+//~ What a wheelCalibrator learned, to checkpoint it
+struct calibrationState{
+  //the nominal track width in meters
+  float trackWidth;
+  //the estimates of rightScale/trackWidth and leftScale/trackWidth
+  double right;
+  double left;
+  //their information matrix (the inverse of their covariance), symmetric
+  double iRR;
+  double iRL;
+  double iLL;
+  //the number of samples used
+  uint64_t count;
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////class///////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Class: wheelCalibrator
+//~ ----------------------------
+//~ Estimates the scale of the two rear wheels from the gyrometer. For a
+//~   differential drive the angle variation is
+//~   deltaTetha = (rightScale*right - leftScale*left)/trackWidth, linear in
+//~   rightScale/trackWidth and leftScale/trackWidth, which are estimated by
+//~   recursive least squares with a forgetting factor: a few numbers per
+//~   robot whatever the number of samples. The forgetting is directional,
+//~   only the information along the direction a sample excites is
+//~   forgotten, so driving straight for a long time does not inflate the
+//~   variance of the turn direction it does not observe.
+//~   The gyrometer only sees the wheels relative to the track width, so the
+//~   scales are given for the nominal track width, and the effective track
+//~   width is the one that explains the rotations with uncorrected wheels.
+class wheelCalibrator{
+  public:
+
+    //~ Function: wheelCalibrator
+    //~ ----------------------------
+    //~ Constructor
+    //~
+    //~ input: float trackWidth; the nominal distance between the two rear
+    //~   wheels in meters, double forgetting; the forgetting factor in ]0, 1]
+    wheelCalibrator(float trackWidth = TRACK_WIDTH,
+      double forgetting = CALIBRATION_FORGETTING);
+    ~wheelCalibrator(void);
+
+    //~ Function: addSample
+    //~ ----------------------------
+    //~ Updates the estimates with one odometry interval
+    //~
+    //~ input: float leftDist, float rightDist; the distances given by the
+    //~   rear wheels, float deltaTetha; the angle variation measured by the
+    //~   gyrometer over the same interval
+    //~
+    //~ output: int is 1 if the sample was used, -1 if the robot did not move
+    int addSample(float leftDist, float rightDist, float deltaTetha);
+
+    //~ Function: getScales
+    //~ ----------------------------
+    //~ Gets the factors to apply to the wheel distances, bounded by
+    //~   CALIBRATION_MAX_CORRECTION
+    //~
+    //~ inout: float &leftScale, float &rightScale; the returned factors
+    //~
+    //~ output: void
+    void getScales(float &leftScale, float &rightScale);
+
+    //~ Function: getEffectiveTrackWidth
+    //~ ----------------------------
+    //~ output: float; the track width in meters that explains the rotations
+    //~   with the uncorrected wheel distances
+    float getEffectiveTrackWidth(void);
+
+    //~ Function: samples
+    //~ ----------------------------
+    //~ output: uint64_t; the number of samples used
+    uint64_t samples(void);
+
+    //~ Function: getState
+    //~ ----------------------------
+    //~ inout: calibrationState &state; the returned estimates
+    //~
+    //~ output: void
+    void getState(calibrationState &state);
+
+    //~ Function: setState
+    //~ ----------------------------
+    //~ Resumes from estimates given by getState
+    //~
+    //~ input: const calibrationState &state; the estimates
+    //~
+    //~ output: int is 1 if suceess, -1 if the track width is not positive or
+    //~   the information matrix not positive definite, nothing changes then
+    int setState(const calibrationState &state);
+
+  private:
+
+    //the nominal track width and the forgetting factor
+    float width;
+    double lambda;
+    //the estimates of rightScale/trackWidth and leftScale/trackWidth
+    double right;
+    double left;
+    //their information matrix, symmetric. It is kept instead of the
+    //covariance for the directional forgetting
+    double iRR;
+    double iRL;
+    double iLL;
+    //the number of samples used
+    uint64_t count = 0;
+};
+
+#endif // WHEEL_CALIBRATION_H
@@ -6,13 +6,37 @@
  * @Last modified time: 2022-02-13T00:13:30+01:00
  */
 
+#include <thread>
+#include <functional>
+
 #include "position_library.h"
+#include "pose_checkpoint.h"
+
+//the file where the robot state is checkpointed
+#define CHECKPOINT_FILE            "dead_reckoning.ckpt"
+//the time between two checkpoints in miliseconds
+#define CHECKPOINT_PERIOD_MS       100
 
 int main(){
 
   robotPosition robot_position;
+  poseCheckpoint checkpoint;
+  robotState state;
+
+  //resume from the last checkpoint instead of re-homing the robot
+  if (checkpoint.openFile(CHECKPOINT_FILE) > 0 &&
+    checkpoint.readLatest(state) > 0){
+    robot_position.restoreState(state);
+  }
+  std::thread checkpointThread(&poseCheckpoint::checkpointLoop, &checkpoint,
+    std::ref(robot_position), CHECKPOINT_PERIOD_MS);
 
+  //slow the acquisitions down while the robot is parked
+  robot_position.setAdaptiveRate();
   robot_position.updateCoordsThreads(100, 50);
+  //the loops were stopped, the checkpoint loop saves the final state
+  checkpoint.stopLoop();
+  checkpointThread.join();
 
   return 0;
 }
@@ -0,0 +1,148 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T17:48:05+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: dead_reckoning_c.cpp
+ * @Last modified time: 2026-10-19T17:48:05+02:00
+ */
+
+#include <new>
+#include <span>
+#include <cstddef>
+
+#include "position_library.h"
+
+#include "dead_reckoning_c.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////structs//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Struct: deadReckoning
+//~ ----------------------------
+//~ The positioning behind the C handle
+struct deadReckoning{
+  robotPosition position;
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+/////////////////////////////functions//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: deadReckoningCreate
+//~ ----------------------------
+//~ Creates the positioning of a robot at [0, 0, 0]
+//~
+//~ output: deadReckoning *; the positioning, NULL if out of memory
+deadReckoning *deadReckoningCreate(void){
+  //no exception may cross the C boundary
+  return new (std::nothrow) deadReckoning;
+}// end function deadReckoningCreate
+
+//~ Function: deadReckoningDestroy
+//~ ----------------------------
+//~ input: deadReckoning *position; the positioning to free, may be NULL
+//~
+//~ output: void
+void deadReckoningDestroy(deadReckoning *position){
+  delete position;
+}// end function deadReckoningDestroy
+
+//~ Function: deadReckoningSetIntegration
+//~ ----------------------------
+//~ input: deadReckoning *position; the positioning, int scheme; one of the
+//~   INTEGRATION_ constants
+//~
+//~ output: int is 1 if suceess, -1 if the scheme is unknown
+int deadReckoningSetIntegration(deadReckoning *position, int scheme){
+  if (position == NULL){
+    return -1;
+  }
+
+  return position->position.setIntegration(scheme);
+}// end function deadReckoningSetIntegration
+
+//~ Function: deadReckoningSetPose
+//~ ----------------------------
+//~ Moves the robot, for example to start a replay from a known pose
+//~
+//~ input: deadReckoning *position; the positioning, const float *pose; the
+//~   [x, y, tetha], uint32_t timestampMS; the time of the pose in
+//~   miliseconds, the next samples are integrated from it
+//~
+//~ output: int is 1 if suceess, -1 if a pointer is NULL
+int deadReckoningSetPose(deadReckoning *position, const float *pose,
+  uint32_t timestampMS){
+
+  if (position == NULL || pose == NULL){
+    return -1;
+  }
+
+  //the calibration is kept, only the pose and the timestamps change
+  robotState state;
+  position->position.saveState(state);
+  state.coords = {pose[0], pose[1], pose[2]};
+  state.lastAngleUpdateMS = state.lastXYUpdateMS = timestampMS;
+  position->position.restoreState(state);
+
+  return 1;
+}// end function deadReckoningSetPose
+
+//~ Function: deadReckoningGetPose
+//~ ----------------------------
+//~ input: deadReckoning *position; the positioning
+//~ inout: float *pose; the returned [x, y, tetha]
+//~
+//~ output: int is 1 if suceess, -1 if a pointer is NULL
+int deadReckoningGetPose(deadReckoning *position, float *pose){
+  if (position == NULL || pose == NULL){
+    return -1;
+  }
+
+  std::array<float, COORDS_SIZE> coords;
+  position->position.getCoords(coords);
+  for (int i = 0; i < COORDS_SIZE; i++){
+    pose[i] = coords[i];
+  }
+
+  return 1;
+}// end function deadReckoningGetPose
+
+//~ Function: deadReckoningIntegrate
+//~ ----------------------------
+//~ Integrates whole arrays of samples in one call, merged by timestamp.
+//~   The arrays are read and written in place, nothing is copied or
+//~   allocated
+//~
+//~ input: deadReckoning *position; the positioning,
+//~   const deadReckoningGyroSample *gyroSamples, size_t gyroCount; the
+//~   gyrometer samples sorted by timestamp,
+//~   const deadReckoningOdometrySample *odometrySamples,
+//~   size_t odometryCount; the odometry samples sorted by timestamp,
+//~   size_t posesCapacity; the size of the poses array, may be 0
+//~ inout: deadReckoningPose *poses; the pose after each sample, written
+//~   until the array is full, may be NULL if posesCapacity is 0
+//~
+//~ output: ptrdiff_t; the number of poses written, -1 if a pointer is NULL
+ptrdiff_t deadReckoningIntegrate(deadReckoning *position,
+  const deadReckoningGyroSample *gyroSamples, size_t gyroCount,
+  const deadReckoningOdometrySample *odometrySamples, size_t odometryCount,
+  deadReckoningPose *poses, size_t posesCapacity){
+
+  if (position == NULL || (gyroSamples == NULL && gyroCount > 0) ||
+    (odometrySamples == NULL && odometryCount > 0) ||
+    (poses == NULL && posesCapacity > 0)){
+
+    return -1;
+  }
+
+  return position->position.integrate(
+    std::span<const deadReckoningGyroSample>(gyroSamples, gyroCount),
+    std::span<const deadReckoningOdometrySample>(odometrySamples,
+    odometryCount),
+    std::span<deadReckoningPose>(poses, posesCapacity));
+}// end function deadReckoningIntegrate
@@ -0,0 +1,298 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T19:24:37+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: event_loop.cpp
+ * @Last modified time: 2026-10-19T19:24:37+02:00
+ */
+
+#include <ctime>
+#include <cerrno>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+#include "event_loop.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////helpers//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: laterDeadline
+//~ ----------------------------
+//~ The order of the timer heap, the nearest deadline on top
+//~
+//~ input: const timerEntry &a, const timerEntry &b; two timers
+//~
+//~ output: bool; true if a is after b
+template <typename entry>
+static bool laterDeadline(const entry &a, const entry &b){
+  return a.deadlineNs > b.deadlineNs;
+}// end function laterDeadline
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////constructor destructor///////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+eventLoop::eventLoop(void){
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  timers.reserve(EVENT_LOOP_TIMERS);
+
+  //the timerfd and the eventfd are told apart by their address
+  if (epollFd >= 0 && timerFd >= 0 && stopFd >= 0){
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = &timerFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event);
+    event.data.ptr = &stopFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event);
+  }
+}
+
+eventLoop::~eventLoop(void){
+  //the tasks still suspended are freed with their frames
+  for (std::coroutine_handle<> handle : tasks){
+    handle.destroy();
+  }
+
+  for (int fd : {epollFd, timerFd, stopFd}){
+    if (fd >= 0){
+      close(fd);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////public methods///////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: spawn
+//~ ----------------------------
+//~ Adds a task to the loop, it starts at the next run
+//~
+//~ input: sensorTask task; the task, the loop frees it
+//~
+//~ output: void
+void eventLoop::spawn(sensorTask task){
+  tasks.push_back(task.handle);
+  started.push_back(task.handle);
+}// end function spawn
+
+//~ Function: run
+//~ ----------------------------
+//~ Runs the tasks until they all returned or stop is called. The tasks
+//~   still suspended then stay in the loop and a later run resumes them
+//~
+//~ output: int is 1 if suceess, -1 if the loop could not be created or
+//~   waiting failed
+int eventLoop::run(void){
+  epoll_event events[EVENT_LOOP_EVENTS];
+  uint64_t value;
+
+  if (epollFd < 0 || timerFd < 0 || stopFd < 0){
+    return -1;
+  }
+
+  //start the new tasks, they run until their first co_await
+  std::vector<std::coroutine_handle<>> starting;
+  starting.swap(started);
+  for (std::coroutine_handle<> handle : starting){
+    resume(handle);
+  }
+
+  while (running && !tasks.empty()){
+    int count = epoll_wait(epollFd, events, EVENT_LOOP_EVENTS, -1);
+    if (count < 0){
+      if (errno == EINTR){
+        continue;
+      }
+      return -1;
+    }
+
+    for (int i = 0; i < count; i++){
+      void *source = events[i].data.ptr;
+      if (source == &timerFd){
+        //the number of expirations does not matter, the heap tells
+        (void) !read(timerFd, &value, sizeof(value));
+        fireTimers();
+      }
+      else if (source == &stopFd){
+        (void) !read(stopFd, &value, sizeof(value));
+      }
+      else{
+        //the waiter lives in the suspended task frame
+        fdAwaiter *awaiter = static_cast<fdAwaiter *>(source);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, awaiter->fd, NULL);
+        stats.fdWakeups++;
+        resume(awaiter->handle);
+      }
+    }
+  }
+
+  //a stop only ends the current run, the loop can run again
+  running = true;
+
+  return 1;
+}// end function run
+
+//~ Function: stop
+//~ ----------------------------
+//~ Makes run return, can be called from any thread. Called while the
+//~   loop does not run, the next run returns once the new tasks started
+//~
+//~ output: void
+void eventLoop::stop(void){
+  uint64_t value = 1;
+
+  running = false;
+  (void) !write(stopFd, &value, sizeof(value));
+}// end function stop
+
+//~ Function: sleepUntil
+//~ ----------------------------
+//~ input: uint64_t deadlineNs; the time given by nowNs to resume at
+//~
+//~ output: timerAwaiter; to co_await
+eventLoop::timerAwaiter eventLoop::sleepUntil(uint64_t deadlineNs){
+  return {*this, deadlineNs};
+}// end function sleepUntil
+
+//~ Function: readable
+//~ ----------------------------
+//~ input: int fd; the file descriptor to wait for
+//~
+//~ output: fdAwaiter; to co_await
+eventLoop::fdAwaiter eventLoop::readable(int fd){
+  return {*this, fd, nullptr, -1};
+}// end function readable
+
+//~ Function: getStats
+//~ ----------------------------
+//~ inout: eventLoopStats &stats; the returned statistics
+//~
+//~ output: void
+void eventLoop::getStats(eventLoopStats &stats){
+  stats = this->stats;
+}// end function getStats
+
+//~ Function: nowNs
+//~ ----------------------------
+//~ output: uint64_t; the monotonic time in nanoseconds of the deadlines
+uint64_t eventLoop::nowNs(void){
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec*1000000000 + now.tv_nsec;
+}// end function nowNs
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////private methods//////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: addTimer
+//~ ----------------------------
+//~ input: uint64_t deadlineNs; when to resume, std::coroutine_handle<>
+//~   handle; the task to resume
+//~
+//~ output: void
+void eventLoop::addTimer(uint64_t deadlineNs,
+  std::coroutine_handle<> handle){
+
+  timers.push_back({deadlineNs, handle});
+  std::push_heap(timers.begin(), timers.end(), laterDeadline<timerEntry>);
+
+  //only a nearer deadline needs the timerfd to move
+  if (armedNs == 0 || deadlineNs < armedNs){
+    armTimer(deadlineNs);
+  }
+}// end function addTimer
+
+//~ Function: addWaiter
+//~ ----------------------------
+//~ input: fdAwaiter *awaiter; the task and the file descriptor to watch
+//~
+//~ output: int is 1 if suceess, -1 if epoll refused the file descriptor
+int eventLoop::addWaiter(fdAwaiter *awaiter){
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.ptr = awaiter;
+
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, awaiter->fd, &event) < 0){
+    return -1;
+  }
+
+  return 1;
+}// end function addWaiter
+
+//~ Function: fireTimers
+//~ ----------------------------
+//~ Resumes the tasks whose deadline passed, then arms the timerfd on the
+//~   next deadline
+//~
+//~ output: void
+void eventLoop::fireTimers(void){
+  uint64_t now = nowNs();
+
+  armedNs = 0;
+  while (!timers.empty() && timers.front().deadlineNs <= now){
+    std::pop_heap(timers.begin(), timers.end(), laterDeadline<timerEntry>);
+    timerEntry timer = timers.back();
+    timers.pop_back();
+
+    uint64_t lateNs = now - timer.deadlineNs;
+    stats.timerWakeups++;
+    stats.totalLateNs += lateNs;
+    stats.maxLateNs = std::max(stats.maxLateNs, lateNs);
+    resume(timer.handle);
+  }
+
+  //the resumed tasks may have armed a nearer deadline already
+  if (!timers.empty() && (armedNs == 0 ||
+    timers.front().deadlineNs < armedNs)){
+
+    armTimer(timers.front().deadlineNs);
+  }
+}// end function fireTimers
+
+//~ Function: armTimer
+//~ ----------------------------
+//~ input: uint64_t deadlineNs; the deadline to arm the timerfd on, 0 to
+//~   disarm it
+//~
+//~ output: void
+void eventLoop::armTimer(uint64_t deadlineNs){
+  itimerspec spec = {};
+  spec.it_value.tv_sec = deadlineNs/1000000000;
+  spec.it_value.tv_nsec = deadlineNs%1000000000;
+
+  timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+  armedNs = deadlineNs;
+}// end function armTimer
+
+//~ Function: resume
+//~ ----------------------------
+//~ Resumes a task and frees it if it returned
+//~
+//~ input: std::coroutine_handle<> handle; the task
+//~
+//~ output: void
+void eventLoop::resume(std::coroutine_handle<> handle){
+  handle.resume();
+
+  if (handle.done()){
+    tasks.erase(std::find(tasks.begin(), tasks.end(), handle));
+    handle.destroy();
+  }
+}// end function resume
@@ -0,0 +1,410 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T09:12:40+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: fleet_index.cpp
+ * @Last modified time: 2026-10-19T09:12:40+02:00
+ */
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include "fleet_index.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////constructor destructor///////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+fleetPoses::fleetPoses(float cellSizeM){
+  cellSize = cellSizeM;
+  invCellSize = 1/cellSizeM;
+}
+
+fleetPoses::~fleetPoses(void){
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////public methods///////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: updatePose
+//~ ----------------------------
+//~ Inserts a cart or updates its pose. If the cart stays in the same cell
+//~   only the pose is rewritten, otherwise it is moved to its new cell in
+//~   constant time
+//~
+//~ input: uint32_t cartId; the cart identifier,
+//~   std::array<float, COORDS_SIZE> pose; the cart pose as [x, y, tetha]
+//~
+//~ output: bool; true if the pose was stored, false if x or y is not finite
+bool fleetPoses::updatePose(uint32_t cartId,
+  std::array<float, COORDS_SIZE> pose){
+
+  if (!std::isfinite(pose[0]) || !std::isfinite(pose[1])){
+    return false;
+  }
+
+  uint64_t key = makeCellKey(cellCoord(pose[0]), cellCoord(pose[1]));
+  auto found = cartSlots.find(cartId);
+
+  //a new cart is appended at the end of the carts and put in its cell
+  if (found == cartSlots.end()){
+    uint32_t slot = carts.size();
+    carts.push_back({cartId, pose, key, 0});
+    cartSlots[cartId] = slot;
+    insertInCell(slot, key);
+    return true;
+  }
+
+  uint32_t slot = found->second;
+  carts[slot].pose = pose;
+  //most of the updates stay in the same cell, then there is nothing to move
+  if (carts[slot].cellKey != key){
+    removeFromCell(slot);
+    insertInCell(slot, key);
+  }
+
+  return true;
+}// end function updatePose
+
+//~ Function: removeCart
+//~ ----------------------------
+//~ Removes a cart from the store
+//~
+//~ input: uint32_t cartId; the cart identifier
+//~
+//~ output: bool; true if the cart was stored, false otherwise
+bool fleetPoses::removeCart(uint32_t cartId){
+  auto found = cartSlots.find(cartId);
+  if (found == cartSlots.end()){
+    return false;
+  }
+
+  uint32_t slot = found->second;
+  uint32_t lastSlot = carts.size() - 1;
+  removeFromCell(slot);
+  cartSlots.erase(found);
+
+  //move the last cart in the freed slot so that the carts stay contiguous
+  if (slot != lastSlot){
+    carts[slot] = carts[lastSlot];
+    cartSlots[carts[slot].cartId] = slot;
+    cells[carts[slot].cellKey][carts[slot].cellSlot] = slot;
+  }
+  carts.pop_back();
+
+  return true;
+}// end function removeCart
+
+//~ Function: getPose
+//~ ----------------------------
+//~ Gets the last pose of a cart
+//~
+//~ input: uint32_t cartId; the cart identifier
+//~ inout: std::array<float, COORDS_SIZE> &pose; the returned pose
+//~
+//~ output: bool; true if the cart was stored, false otherwise
+bool fleetPoses::getPose(uint32_t cartId,
+  std::array<float, COORDS_SIZE> &pose) const{
+
+  auto found = cartSlots.find(cartId);
+  if (found == cartSlots.end()){
+    return false;
+  }
+  pose = carts[found->second].pose;
+
+  return true;
+}// end function getPose
+
+//~ Function: size
+//~ ----------------------------
+//~ output: size_t; the number of carts stored
+size_t fleetPoses::size(void) const{
+  return carts.size();
+}// end function size
+
+//~ Function: radiusQuery
+//~ ----------------------------
+//~ Finds all the carts within a distance of a point
+//~
+//~ input: std::array<float, XY_COORDS_SIZE> center; the [x, y] point,
+//~   float radiusM; the search radius in meters
+//~ inout: std::vector<uint32_t> &cartIds; cleared then filled with the ids
+//~   of the carts found, in no particular order
+//~
+//~ output: size_t; the number of carts found, 0 if an input is not finite
+size_t fleetPoses::radiusQuery(std::array<float, XY_COORDS_SIZE> center,
+  float radiusM, std::vector<uint32_t> &cartIds) const{
+
+  float radius2 = radiusM*radiusM;
+  cartIds.clear();
+
+  if (!std::isfinite(center[0]) || !std::isfinite(center[1]) ||
+    !std::isfinite(radiusM) || radiusM < 0){
+    return 0;
+  }
+
+  //only the cells overlapping the bounding box of the circle are visited
+  visitCells(cellCoord(center[0] - radiusM), cellCoord(center[1] - radiusM),
+    cellCoord(center[0] + radiusM), cellCoord(center[1] + radiusM),
+    [&](uint32_t slot){
+      float dx = carts[slot].pose[0] - center[0];
+      float dy = carts[slot].pose[1] - center[1];
+      if (dx*dx + dy*dy <= radius2){
+        cartIds.push_back(carts[slot].cartId);
+      }
+    });
+
+  return cartIds.size();
+}// end function radiusQuery
+
+//~ Function: zoneQuery
+//~ ----------------------------
+//~ Finds all the carts inside a rectangular zone aligned with the axis
+//~
+//~ input: std::array<float, XY_COORDS_SIZE> minCorner; the [x, y] lower
+//~   corner, std::array<float, XY_COORDS_SIZE> maxCorner; the [x, y] upper
+//~   corner
+//~ inout: std::vector<uint32_t> &cartIds; cleared then filled with the ids
+//~   of the carts found, in no particular order
+//~
+//~ output: size_t; the number of carts found, 0 if an input is not finite
+size_t fleetPoses::zoneQuery(std::array<float, XY_COORDS_SIZE> minCorner,
+  std::array<float, XY_COORDS_SIZE> maxCorner,
+  std::vector<uint32_t> &cartIds) const{
+
+  cartIds.clear();
+
+  if (!std::isfinite(minCorner[0]) || !std::isfinite(minCorner[1]) ||
+    !std::isfinite(maxCorner[0]) || !std::isfinite(maxCorner[1])){
+    return 0;
+  }
+
+  visitCells(cellCoord(minCorner[0]), cellCoord(minCorner[1]),
+    cellCoord(maxCorner[0]), cellCoord(maxCorner[1]),
+    [&](uint32_t slot){
+      const std::array<float, COORDS_SIZE> &pose = carts[slot].pose;
+      if (pose[0] >= minCorner[0] && pose[0] <= maxCorner[0] &&
+        pose[1] >= minCorner[1] && pose[1] <= maxCorner[1]){
+        cartIds.push_back(carts[slot].cartId);
+      }
+    });
+
+  return cartIds.size();
+}// end function zoneQuery
+
+//~ Function: kNearest
+//~ ----------------------------
+//~ Finds the k carts closest to a point by visiting rings of cells around
+//~   it until no unvisited cell can hold a closer cart
+//~
+//~ input: std::array<float, XY_COORDS_SIZE> center; the [x, y] point,
+//~   size_t k; the number of carts wanted
+//~ inout: std::vector<uint32_t> &cartIds; cleared then filled with the ids
+//~   of the carts found, from the closest to the farthest
+//~
+//~ output: size_t; the number of carts found, min(k, size())
+size_t fleetPoses::kNearest(std::array<float, XY_COORDS_SIZE> center,
+  size_t k, std::vector<uint32_t> &cartIds) const{
+
+  //the best carts found so far as (squared distance, slot), kept as a max heap
+  std::vector<std::pair<float, uint32_t>> best;
+  size_t visited = 0;
+
+  cartIds.clear();
+  k = std::min(k, carts.size());
+  if (k == 0 || !std::isfinite(center[0]) || !std::isfinite(center[1])){
+    return 0;
+  }
+
+  int32_t cx0 = cellCoord(center[0]);
+  int32_t cy0 = cellCoord(center[1]);
+  best.reserve(k + 1);
+
+  //keeps the candidate if it is closer than the worst of the best ones
+  auto consider = [&](uint32_t slot){
+    float dx = carts[slot].pose[0] - center[0];
+    float dy = carts[slot].pose[1] - center[1];
+    float dist2 = dx*dx + dy*dy;
+    if (best.size() < k){
+      best.push_back({dist2, slot});
+      std::push_heap(best.begin(), best.end());
+    }
+    else if (dist2 < best.front().first){
+      std::pop_heap(best.begin(), best.end());
+      best.back() = {dist2, slot};
+      std::push_heap(best.begin(), best.end());
+    }
+  };
+
+  for (int32_t ring = 0; visited < carts.size(); ring++){
+    //a cell of this ring is at least (ring - 1) cells away from the center
+    float ringDist = (ring - 1)*cellSize;
+    if (best.size() == k && ring > 0 && best.front().first <= ringDist*ringDist){
+      break;
+    }
+
+    //once the ring has more cells than the grid, scanning the cells is cheaper
+    if ((uint64_t) (2*ring + 1)*(2*ring + 1) > cells.size()){
+      best.clear();
+      for (uint32_t slot = 0; slot < carts.size(); slot++){
+        consider(slot);
+      }
+      break;
+    }
+
+    //walk along the border of the square of side 2*ring + 1
+    for (int32_t cx = cx0 - ring; cx <= cx0 + ring; cx++){
+      int32_t step = (cx == cx0 - ring || cx == cx0 + ring) ? 1 : 2*ring;
+      for (int32_t cy = cy0 - ring; cy <= cy0 + ring; cy += (ring ? step : 1)){
+        auto cell = cells.find(makeCellKey(cx, cy));
+        if (cell == cells.end()){
+          continue;
+        }
+        for (uint32_t slot : cell->second){
+          consider(slot);
+        }
+        visited += cell->second.size();
+      }
+    }
+  }
+
+  std::sort_heap(best.begin(), best.end());
+  for (const std::pair<float, uint32_t> &candidate : best){
+    cartIds.push_back(carts[candidate.second].cartId);
+  }
+
+  return cartIds.size();
+}// end function kNearest
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////private methods//////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: cellCoord
+//~ ----------------------------
+//~ input: float coord; a x or y coordinate in meters
+//~
+//~ output: int32_t; the index of the cell holding it on that axis, clamped
+//~   to [-FLEET_MAX_CELL, FLEET_MAX_CELL]. The callers reject the non finite
+//~   coordinates, a NaN still gives -FLEET_MAX_CELL instead of an undefined
+//~   cast
+int32_t fleetPoses::cellCoord(float coord) const{
+  float cell = std::floor(coord*invCellSize);
+
+  //written so that a NaN fails the first test
+  if (!(cell > -FLEET_MAX_CELL)){
+    return -FLEET_MAX_CELL;
+  }
+  if (cell > FLEET_MAX_CELL){
+    return FLEET_MAX_CELL;
+  }
+
+  return (int32_t) cell;
+}// end function cellCoord
+
+//~ Function: visitCells
+//~ ----------------------------
+//~ Calls a function on every cart of the cells of a box. When the box holds
+//~   more cells than the map, the occupied cells are scanned instead, so a
+//~   query never costs more than the number of occupied cells
+//~
+//~ input: int32_t cxMin, int32_t cyMin; the lower cell of the box,
+//~   int32_t cxMax, int32_t cyMax; the upper cell of the box,
+//~   visitor visit; called with the position in carts of each cart found
+//~
+//~ output: void
+template <typename visitor>
+void fleetPoses::visitCells(int32_t cxMin, int32_t cyMin, int32_t cxMax,
+  int32_t cyMax, visitor visit) const{
+
+  if (cxMax < cxMin || cyMax < cyMin){
+    return;
+  }
+
+  //the indexes are clamped to FLEET_MAX_CELL, the product fits in 64 bits
+  uint64_t boxCells = (uint64_t) ((int64_t) cxMax - cxMin + 1)*
+    (uint64_t) ((int64_t) cyMax - cyMin + 1);
+  if (boxCells > cells.size()){
+    for (const auto &cell : cells){
+      int32_t cx = (int32_t) (uint32_t) (cell.first >> 32);
+      int32_t cy = (int32_t) (uint32_t) cell.first;
+      if (cx < cxMin || cx > cxMax || cy < cyMin || cy > cyMax){
+        continue;
+      }
+      for (uint32_t slot : cell.second){
+        visit(slot);
+      }
+    }
+    return;
+  }
+
+  for (int32_t cx = cxMin; cx <= cxMax; cx++){
+    for (int32_t cy = cyMin; cy <= cyMax; cy++){
+      auto cell = cells.find(makeCellKey(cx, cy));
+      if (cell == cells.end()){
+        continue;
+      }
+      for (uint32_t slot : cell->second){
+        visit(slot);
+      }
+    }
+  }
+}// end function visitCells
+
+//~ Function: makeCellKey
+//~ ----------------------------
+//~ input: int32_t cx, int32_t cy; the cell indexes on the x and y axis
+//~
+//~ output: uint64_t; the key of the cell in the cells map
+uint64_t fleetPoses::makeCellKey(int32_t cx, int32_t cy) const{
+  return ((uint64_t) (uint32_t) cx << 32) | (uint32_t) cy;
+}// end function makeCellKey
+
+//~ Function: insertInCell
+//~ ----------------------------
+//~ Adds a cart to the list of a cell
+//~
+//~ input: uint32_t slot; the position of the cart in carts,
+//~   uint64_t key; the key of the cell
+//~
+//~ output: void
+void fleetPoses::insertInCell(uint32_t slot, uint64_t key){
+  std::vector<uint32_t> &cell = cells[key];
+  carts[slot].cellKey = key;
+  carts[slot].cellSlot = cell.size();
+  cell.push_back(slot);
+}// end function insertInCell
+
+//~ Function: removeFromCell
+//~ ----------------------------
+//~ Removes a cart from the list of its cell in constant time by swapping it
+//~   with the last cart of the list
+//~
+//~ input: uint32_t slot; the position of the cart in carts
+//~
+//~ output: void
+void fleetPoses::removeFromCell(uint32_t slot){
+  auto cell = cells.find(carts[slot].cellKey);
+  std::vector<uint32_t> &list = cell->second;
+  uint32_t cellSlot = carts[slot].cellSlot;
+
+  list[cellSlot] = list.back();
+  carts[list[cellSlot]].cellSlot = cellSlot;
+  list.pop_back();
+
+  //empty cells are dropped so that the map only holds occupied cells
+  if (list.empty()){
+    cells.erase(cell);
+  }
+}// end function removeFromCell
@@ -0,0 +1,243 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T10:05:12+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: pose_checkpoint.cpp
+ * @Last modified time: 2026-10-19T10:05:12+02:00
+ */
+
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <iostream>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "pose_checkpoint.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////constructor destructor///////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+poseCheckpoint::poseCheckpoint(void){
+}
+
+poseCheckpoint::~poseCheckpoint(void){
+  closeFile();
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////public methods///////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: openFile
+//~ ----------------------------
+//~ Opens the checkpoint file, creates and preallocates it if needed
+//~
+//~ input: const char *path; the path of the checkpoint file
+//~
+//~ output: int is 1 if suceess, -1 if error
+int poseCheckpoint::openFile(const char *path){
+  checkpointRecord record;
+
+  closeFile();
+  fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0){
+    return -1;
+  }
+  //reserve the blocks now so that a checkpoint never waits for an allocation
+  if (posix_fallocate(fd, 0, CHECKPOINT_SLOTS*CHECKPOINT_SLOT_SIZE) != 0){
+    closeFile();
+    return -1;
+  }
+
+  //continue the sequence of the records already in the file
+  sequence = 0;
+  for (int slot = 0; slot < CHECKPOINT_SLOTS; slot++){
+    if (readSlot(slot, record) > 0 && record.sequence > sequence){
+      sequence = record.sequence;
+    }
+  }
+
+  return 1;
+}// end function openFile
+
+//~ Function: closeFile
+//~ ----------------------------
+//~ Closes the checkpoint file
+//~
+//~ output: void
+void poseCheckpoint::closeFile(void){
+  if (fd >= 0){
+    close(fd);
+    fd = -1;
+  }
+}// end function closeFile
+
+//~ Function: writeState
+//~ ----------------------------
+//~ Writes a state in the oldest slot and flushes it to the disk
+//~
+//~ input: const robotState &state; the state to checkpoint
+//~
+//~ output: int is 1 if suceess, -1 if error
+int poseCheckpoint::writeState(const robotState &state){
+  checkpointRecord record;
+
+  if (fd < 0){
+    return -1;
+  }
+
+  //zero the padding too, it is part of the crc
+  memset(&record, 0, sizeof(record));
+  record.magic = CHECKPOINT_MAGIC;
+  record.version = CHECKPOINT_VERSION;
+  record.sequence = sequence + 1;
+  record.state = state;
+  record.crc = crc32(&record, offsetof(checkpointRecord, crc));
+
+  //the slots alternate, the one holding the latest record is never touched
+  off_t offset = (record.sequence % CHECKPOINT_SLOTS)*CHECKPOINT_SLOT_SIZE;
+  if (pwrite(fd, &record, sizeof(record), offset) !=
+    (ssize_t) sizeof(record)){
+    return -1;
+  }
+  if (fdatasync(fd) != 0){
+    return -1;
+  }
+  sequence = record.sequence;
+
+  return 1;
+}// end function writeState
+
+//~ Function: readLatest
+//~ ----------------------------
+//~ Reads the most recent valid checkpoint of the file
+//~
+//~ inout: robotState &state; the returned state
+//~
+//~ output: int is 1 if suceess, -1 if there is no valid checkpoint
+int poseCheckpoint::readLatest(robotState &state){
+  checkpointRecord record;
+  uint64_t latest = 0;
+
+  for (int slot = 0; slot < CHECKPOINT_SLOTS; slot++){
+    if (readSlot(slot, record) > 0 && record.sequence > latest){
+      latest = record.sequence;
+      state = record.state;
+    }
+  }
+
+  return latest > 0 ? 1 : -1;
+}// end function readLatest
+
+//~ Function: checkpointLoop
+//~ ----------------------------
+//~ The loop that checkpoints the robot state. It runs on its own thread so
+//~   the gyrometer and odometry loops never wait for the disk. Once
+//~   stopLoop is called it writes a last checkpoint and returns
+//~
+//~ input: robotPosition &robot; the robot to checkpoint,
+//~   int periodMs; the time between two checkpoints in miliseconds
+//~
+//~ output: void
+void poseCheckpoint::checkpointLoop(robotPosition &robot, int periodMs){
+  robotState state;
+  bool last = false;
+
+  //the state at the stop is checkpointed too, for the next warm restart
+  while(!last){
+    last = !running;
+    robot.saveState(state);
+    if (writeState(state) < 0){
+      writeFailures++;
+#ifdef DEBUG
+      std::cerr << "checkpoint write failed, failures : " << writeFailures
+        << std::endl;
+#endif
+    }
+
+    if (!last){
+      std::unique_lock<std::mutex> lock(loopMutex);
+      loopStopped.wait_for(lock, std::chrono::milliseconds(periodMs),
+        [this]{ return !running; });
+    }
+  }// end while loop
+}// end function checkpointLoop
+
+//~ Function: stopLoop
+//~ ----------------------------
+//~ Makes checkpointLoop return without waiting for the end of its period
+//~
+//~ output: void
+void poseCheckpoint::stopLoop(void){
+  std::lock_guard<std::mutex> lock(loopMutex);
+  running = false;
+  loopStopped.notify_all();
+}// end function stopLoop
+
+//~ Function: getWriteFailures
+//~ ----------------------------
+//~ output: uint64_t; the number of checkpoints checkpointLoop could not
+//~   write
+uint64_t poseCheckpoint::getWriteFailures(void){
+  return writeFailures;
+}// end function getWriteFailures
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////private methods//////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: readSlot
+//~ ----------------------------
+//~ Reads and validates the record of a slot
+//~
+//~ input: int slot; the slot index
+//~ inout: checkpointRecord &record; the returned record
+//~
+//~ output: int is 1 if the slot holds a valid record, -1 otherwise
+int poseCheckpoint::readSlot(int slot, checkpointRecord &record){
+  if (fd < 0){
+    return -1;
+  }
+  if (pread(fd, &record, sizeof(record), slot*CHECKPOINT_SLOT_SIZE) !=
+    (ssize_t) sizeof(record)){
+    return -1;
+  }
+  //a torn or never written slot fails one of these checks
+  if (record.magic != CHECKPOINT_MAGIC || record.version != CHECKPOINT_VERSION
+    || record.sequence == 0 ||
+    record.crc != crc32(&record, offsetof(checkpointRecord, crc))){
+    return -1;
+  }
+
+  return 1;
+}// end function readSlot
+
+//~ Function: crc32
+//~ ----------------------------
+//~ Calculates the crc32 of a buffer
+//~
+//~ input: const void *data; the buffer, size_t size; its size in bytes
+//~
+//~ output: uint32_t; the crc32 of the buffer
+uint32_t poseCheckpoint::crc32(const void *data, size_t size){
+  const uint8_t *bytes = (const uint8_t *) data;
+  uint32_t crc = 0xFFFFFFFF;
+
+  for (size_t i = 0; i < size; i++){
+    crc ^= bytes[i];
+    for (int bit = 0; bit < 8; bit++){
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+
+  return ~crc;
+}// end function crc32
@@ -0,0 +1,315 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T11:20:31+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: pose_smoother.cpp
+ * @Last modified time: 2026-10-19T11:20:31+02:00
+ */
+
+#include <cmath>
+#include <array>
+#include <vector>
+
+#include "pose_smoother.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////constructor destructor///////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+poseSmoother::poseSmoother(size_t windowSize,
+  std::array<float, COORDS_SIZE> initialPose){
+
+  //the window always holds at least the pose the samples start from
+  if (windowSize < 2){
+    windowSize = 2;
+  }
+  nodes.resize(windowSize);
+  tethaD.resize(windowSize);
+  tethaL.resize(windowSize);
+  xyD.resize(windowSize);
+  xyL.resize(windowSize);
+  rhs.resize(windowSize);
+  rhsY.resize(windowSize);
+
+  for (int i = 0; i < COORDS_SIZE; i++){
+    prior[i] = initialPose[i];
+  }
+  nodes[0] = {0, 0, false, {0, 0, 0}, prior};
+  count = 1;
+
+  setNoise(SMOOTHER_GYRO_STD, SMOOTHER_ODOMETRY_STD, SMOOTHER_FIX_XY_STD,
+    SMOOTHER_FIX_TETHA_STD);
+}
+
+poseSmoother::~poseSmoother(void){
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////public methods///////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: setNoise
+//~ ----------------------------
+//~ Sets the standard deviations used to weight the measurements
+//~
+//~ input: double gyroStd; of an angle increment in rads, double odometryStd;
+//~   of a distance increment in meters, double fixXYStd; of an absolute x
+//~   or y in meters, double fixTethaStd; of an absolute angle in rads
+//~
+//~ output: void
+void poseSmoother::setNoise(double gyroStd, double odometryStd,
+  double fixXYStd, double fixTethaStd){
+
+  gyroWeight = 1/(gyroStd*gyroStd);
+  odometryWeight = 1/(odometryStd*odometryStd);
+  fixXYWeight = 1/(fixXYStd*fixXYStd);
+  fixTethaWeight = 1/(fixTethaStd*fixTethaStd);
+  priorWeight = 1/(SMOOTHER_PRIOR_STD*SMOOTHER_PRIOR_STD);
+  factorValid = false;
+}// end function setNoise
+
+//~ Function: addSample
+//~ ----------------------------
+//~ Adds a new pose to the window, linked to the previous one. Once the
+//~   window is full the oldest pose leaves it and becomes the prior, and
+//~   the next solve refactorizes if a fix is left in the window
+//~
+//~ input: float deltaDist; the distance traveled since the last sample as
+//~   given by calculateDeltaDist, float deltaTetha; the angle variation
+//~   since the last sample
+//~
+//~ output: void
+void poseSmoother::addSample(float deltaDist, float deltaTetha){
+  std::array<double, COORDS_SIZE> last = node(count - 1).pose;
+  bool full = count == nodes.size();
+  bool windowHasFix = false;
+
+  //slide the window, the new oldest pose keeps its current estimate as prior
+  if (full){
+    for (size_t i = 0; i < count && !windowHasFix; i++){
+      windowHasFix = node(i).hasFix;
+    }
+    head = (head + 1) % nodes.size();
+    count--;
+    prior = node(0).pose;
+  }
+
+  //the new pose starts from the forward integration of the sample
+  double tetha = last[2] + deltaTetha;
+  double tethaMid = last[2] + deltaTetha/2;
+  smootherNode &newNode = node(count);
+  newNode.deltaDist = deltaDist;
+  newNode.deltaTetha = deltaTetha;
+  newNode.hasFix = false;
+  newNode.pose = {last[0] + deltaDist*cos(tethaMid),
+    last[1] + deltaDist*sin(tethaMid), tetha};
+
+  //sliding moves every fix by one row, the systems only keep their structure
+  //when the window was already full and holds no fix
+  if (!full || windowHasFix){
+    factorValid = false;
+  }
+  count++;
+}// end function addSample
+
+//~ Function: addFix
+//~ ----------------------------
+//~ Adds an absolute measurement of the newest pose
+//~
+//~ input: std::array<float, COORDS_SIZE> fix; the measured [x, y, tetha]
+//~
+//~ output: void
+void poseSmoother::addFix(std::array<float, COORDS_SIZE> fix){
+  smootherNode &newest = node(count - 1);
+
+  //unwrap the fix angle next to the current estimate
+  double turns = round((newest.pose[2] - fix[2])/(2*PI));
+  newest.fix = {fix[0], fix[1], fix[2] + turns*2*PI};
+  newest.hasFix = true;
+  factorValid = false;
+}// end function addFix
+
+//~ Function: solve
+//~ ----------------------------
+//~ Smooths all the poses of the window, in O(window)
+//~
+//~ output: void
+void poseSmoother::solve(void){
+  if (!factorValid){
+    factorize();
+  }
+
+  //angles: the prior, the fixes and the gyrometer increments
+  for (size_t i = 0; i < count; i++){
+    smootherNode &current = node(i);
+    rhs[i] = current.hasFix ? fixTethaWeight*current.fix[2] : 0;
+    if (i > 0){
+      rhs[i - 1] -= gyroWeight*current.deltaTetha;
+      rhs[i] += gyroWeight*current.deltaTetha;
+    }
+  }
+  rhs[0] += priorWeight*prior[2];
+  solveTridiagonal(tethaD, tethaL, rhs);
+  for (size_t i = 0; i < count; i++){
+    node(i).pose[2] = rhs[i];
+  }
+
+  //x and y: the distances are projected on the smoothed mean angles
+  for (size_t i = 0; i < count; i++){
+    smootherNode &current = node(i);
+    rhs[i] = current.hasFix ? fixXYWeight*current.fix[0] : 0;
+    rhsY[i] = current.hasFix ? fixXYWeight*current.fix[1] : 0;
+    if (i > 0){
+      double tethaMid = MEAN(node(i - 1).pose[2], current.pose[2]);
+      double dx = odometryWeight*current.deltaDist*cos(tethaMid);
+      double dy = odometryWeight*current.deltaDist*sin(tethaMid);
+      rhs[i - 1] -= dx;
+      rhs[i] += dx;
+      rhsY[i - 1] -= dy;
+      rhsY[i] += dy;
+    }
+  }
+  rhs[0] += priorWeight*prior[0];
+  rhsY[0] += priorWeight*prior[1];
+  solveTridiagonal(xyD, xyL, rhs);
+  solveTridiagonal(xyD, xyL, rhsY);
+  for (size_t i = 0; i < count; i++){
+    node(i).pose[0] = rhs[i];
+    node(i).pose[1] = rhsY[i];
+  }
+}// end function solve
+
+//~ Function: getPose
+//~ ----------------------------
+//~ Gets a pose of the window, as smoothed by the last solve
+//~
+//~ input: size_t lag; the number of samples between the newest pose and
+//~   the one wanted, 0 for the newest
+//~ inout: std::array<float, COORDS_SIZE> &pose; the returned [x, y, tetha]
+//~
+//~ output: int is 1 if suceess, -1 if the lag is outside of the window
+int poseSmoother::getPose(size_t lag, std::array<float, COORDS_SIZE> &pose){
+  if (lag >= count){
+    return -1;
+  }
+
+  smootherNode &wanted = node(count - 1 - lag);
+  pose[0] = wanted.pose[0];
+  pose[1] = wanted.pose[1];
+  pose[2] = fmod(wanted.pose[2], 2*PI);
+
+  return 1;
+}// end function getPose
+
+//~ Function: size
+//~ ----------------------------
+//~ output: size_t; the number of poses in the window
+size_t poseSmoother::size(void){
+  return count;
+}// end function size
+
+//~ Function: factorizations
+//~ ----------------------------
+//~ output: uint64_t; the number of times the systems were factorized
+uint64_t poseSmoother::factorizations(void){
+  return factorCount;
+}// end function factorizations
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////private methods//////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: node
+//~ ----------------------------
+//~ input: size_t i; the position of the pose in the window, 0 is the oldest
+//~
+//~ output: smootherNode &; the pose
+poseSmoother::smootherNode &poseSmoother::node(size_t i){
+  size_t index = head + i;
+
+  //cheaper than a modulo, i is always smaller than the window size
+  if (index >= nodes.size()){
+    index -= nodes.size();
+  }
+
+  return nodes[index];
+}// end function node
+
+//~ Function: factorize
+//~ ----------------------------
+//~ Factorizes the angle and the x and y systems of the current window
+//~
+//~ output: void
+void poseSmoother::factorize(void){
+  factorizeTridiagonal(gyroWeight, fixTethaWeight, tethaD, tethaL);
+  factorizeTridiagonal(odometryWeight, fixXYWeight, xyD, xyL);
+  factorValid = true;
+  factorCount++;
+}// end function factorize
+
+//~ Function: factorizeTridiagonal
+//~ ----------------------------
+//~ Calculates the LDLt factorization of a tridiagonal system built from
+//~   the chain of samples, the fixes and the prior
+//~
+//~ input: double edgeWeight; the weight of a sample, double fixWeight; the
+//~   weight of a fix
+//~ inout: std::vector<double> &d; the returned inverse of the diagonal,
+//~   std::vector<double> &l; the returned sub-diagonal
+//~
+//~ output: void
+void poseSmoother::factorizeTridiagonal(double edgeWeight, double fixWeight,
+  std::vector<double> &d, std::vector<double> &l){
+
+  for (size_t i = 0; i < count; i++){
+    //each pose is pulled by the samples before and after it and by its fix
+    double diagonal = node(i).hasFix ? fixWeight : 0;
+    if (i > 0){
+      diagonal += edgeWeight;
+    }
+    if (i + 1 < count){
+      diagonal += edgeWeight;
+    }
+
+    if (i == 0){
+      diagonal += priorWeight;
+      l[0] = 0;
+    }
+    else{
+      l[i] = -edgeWeight*d[i - 1];
+      diagonal += edgeWeight*l[i];
+    }
+    d[i] = 1/diagonal;
+  }
+}// end function factorizeTridiagonal
+
+//~ Function: solveTridiagonal
+//~ ----------------------------
+//~ Solves a factorized tridiagonal system in place
+//~
+//~ input: const std::vector<double> &d, const std::vector<double> &l; the
+//~   factorization
+//~ inout: std::vector<double> &b; the right hand side, returned solution
+//~
+//~ output: void
+void poseSmoother::solveTridiagonal(const std::vector<double> &d,
+  const std::vector<double> &l, std::vector<double> &b){
+
+  //forward substitution with L, then D
+  for (size_t i = 1; i < count; i++){
+    b[i] -= l[i]*b[i - 1];
+  }
+  for (size_t i = 0; i < count; i++){
+    b[i] *= d[i];
+  }
+  //backward substitution with Lt
+  for (size_t i = count - 1; i > 0; i--){
+    b[i - 1] -= l[i]*b[i];
+  }
+}// end function solveTridiagonal
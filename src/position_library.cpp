@@ -8,14 +8,80 @@
 
 #include <cmath>
 #include <array>
+
+#ifndef STATIC_POSITION
 #include <chrono>
 #include <thread>
+#include <algorithm>
 #include <iostream>
 
 #include "libraries_mockup.h"
+#include "event_loop.h"
+#endif
 
 #include "position_library.h"
 
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////helpers//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the field accesses that differ between the library samples and the C ones,
+//so that integrateSamples reads and writes both in place
+
+//~ Function: sampleOdometry
+//~ ----------------------------
+//~ input: const odometrySample &sample; a library odometry sample
+//~
+//~ output: const std::array<float, 4> &; its odometry
+static const std::array<float, 4> &sampleOdometry(
+  const odometrySample &sample){
+
+  return sample.odometry;
+}// end function sampleOdometry
+
+//~ Function: sampleOdometry
+//~ ----------------------------
+//~ input: const deadReckoningOdometrySample &sample; a C odometry sample
+//~
+//~ output: std::array<float, 4>; its odometry, loaded field by field
+static std::array<float, 4> sampleOdometry(
+  const deadReckoningOdometrySample &sample){
+
+  return {sample.odometry[0], sample.odometry[1], sample.odometry[2],
+    sample.odometry[3]};
+}// end function sampleOdometry
+
+//~ Function: writePose
+//~ ----------------------------
+//~ input: uint32_t timestampMS; the time of the pose,
+//~   const std::array<float, COORDS_SIZE> &pose; the [x, y, tetha]
+//~ inout: trajectoryPoint &point; the library pose written
+//~
+//~ output: void
+static void writePose(trajectoryPoint &point, uint32_t timestampMS,
+  const std::array<float, COORDS_SIZE> &pose){
+
+  point = {timestampMS, pose};
+}// end function writePose
+
+//~ Function: writePose
+//~ ----------------------------
+//~ input: uint32_t timestampMS; the time of the pose,
+//~   const std::array<float, COORDS_SIZE> &pose; the [x, y, tetha]
+//~ inout: deadReckoningPose &point; the C pose written field by field
+//~
+//~ output: void
+static void writePose(deadReckoningPose &point, uint32_t timestampMS,
+  const std::array<float, COORDS_SIZE> &pose){
+
+  point.timestampMS = timestampMS;
+  for (int i = 0; i < COORDS_SIZE; i++){
+    point.pose[i] = pose[i];
+  }
+}// end function writePose
+
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 ///////////////////////constructor destructor///////////////////////////
@@ -34,6 +100,7 @@ robotPosition::~robotPosition(void){
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 
+#ifndef STATIC_POSITION
 //~ Function: updateCoordsThreads
 //~ ----------------------------
 //~ Creates two threads, one for updating the gyrometer data and one for
@@ -73,24 +140,31 @@ void robotPosition::updateAngleLoop(int gyroFreqHz){
   auto start = high_resolution_clock::now();
 
   //loop in which we refresh the angle via the gyrometer data
-  while(1){
+  while(running){
+    gyroWakeups++;
     //get the yaw rate and its timestamp
     ret = gyrometerAcq(yawRate, timestamp);
     //if the acquisition was sucessful, we treat the information, if not, retry
     if (ret > 0){
-      //update the yaw angle with the elapsed time between two updates
-      updateAngle(yawRate, timestamp - lastAngleUpdateMS);
-      //update the last time we updaed the yaw angle
-      lastAngleUpdateMS = timestamp;
+      {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        //update the yaw angle with the elapsed time between two updates
+        updateAngle(yawRate, timestamp - lastAngleUpdateMS);
+        //update the last time we updaed the yaw angle
+        lastAngleUpdateMS = timestamp;
+      }
+      //a yaw rate under the threshold shows the robot still
+      updateMotion(fabs(yawRate) < stillYawRate);
       auto end = high_resolution_clock::now();
       auto timeElapsed = duration_cast<milliseconds>(end - start);
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000/gyroFreqHz - timeElapsed.count()));
+      int periodMS = loopPeriodMS(gyroFreqHz);
+      waitPeriod(periodMS - timeElapsed.count());
       start = high_resolution_clock::now();
 
       //print some information if we are in debug mode
 #ifdef DEBUG
       std::cout << "yaw rate : " << yawRate <<", timestamp : " << timestamp <<
-        ", loop period : " << 1000/gyroFreqHz -
+        ", loop period : " << periodMS -
         std::chrono::duration_cast<std::chrono::milliseconds>(timeElapsed).count()
         << std::endl;
 #endif
@@ -106,8 +180,10 @@ void robotPosition::updateAngleLoop(int gyroFreqHz){
 //~
 //~ output: void
 void robotPosition::updateXYLoop(int odometryFreqHz){
-  std::array<float, 4> odometry;
+  std::array<float, 4> odometry = {0, 0, 0, 0};
   uint32_t timestamp = 0;
+  uint32_t deltaMS = 0;
+  bool still = true;
   int ret = 1;
   using std::chrono::high_resolution_clock;
   using std::chrono::duration_cast;
@@ -116,24 +192,37 @@ void robotPosition::updateXYLoop(int odometryFreqHz){
   auto start = high_resolution_clock::now();
 
   //loop in which we refresh the x and y position via the odometry data
-  while(1){
+  while(running){
+    odometryWakeups++;
     //get the odometry and its timestamp
     ret = odometryAcq(odometry, timestamp);
     //if the acquisition was sucessful, we treat the information, if not, retry
     if (ret > 0){
-      //update the x and y coordinates with the elapsed time between two updates
-      updateXY(odometry, timestamp - lastXYUpdateMS);
-      //update the last time we updaed the X and Y coordiates
-      lastXYUpdateMS = timestamp;
+      {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        //update the x and y coordinates with the elapsed time between two updates
+        deltaMS = timestamp - lastXYUpdateMS;
+        updateXY(odometry, deltaMS);
+        //update the last time we updaed the X and Y coordiates
+        lastXYUpdateMS = timestamp;
+        emitPose(timestamp);
+      }
+      //wheels all slower than the threshold show the robot still
+      still = true;
+      for (int i = 0; i < 4; i++){
+        still = still && fabs(odometry[i])*1000 <= stillSpeed*deltaMS;
+      }
+      updateMotion(still);
       auto end = high_resolution_clock::now();
       auto timeElapsed = duration_cast<milliseconds>(end - start);
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000/odometryFreqHz - timeElapsed.count()));
+      int periodMS = loopPeriodMS(odometryFreqHz);
+      waitPeriod(periodMS - timeElapsed.count());
       start = high_resolution_clock::now();
 
       //print some information if we are in debug mode
 #ifdef DEBUG
       std::cout << "odometry : " << odometry[0] << " " << odometry[1] <<
-        ", timestamp : " << timestamp << ", loop period : " << 1000/odometryFreqHz -
+        ", timestamp : " << timestamp << ", loop period : " << periodMS -
         std::chrono::duration_cast<std::chrono::milliseconds>(timeElapsed).count()
         << std::endl;
 #endif
@@ -141,6 +230,305 @@ void robotPosition::updateXYLoop(int odometryFreqHz){
   }// end while loop
 }// end function updateXYLoop
 
+//~ Function: updateCoordsTasks
+//~ ----------------------------
+//~ Spawns the gyrometer and the odometry acquisitions as two tasks of an
+//~   event loop, the updates then run on the thread calling loop.run
+//~   next to any other task of the loop. Unlike the threads, the two
+//~   updates never run at the same time and their periods do not drift
+//~
+//~ input: eventLoop &loop; the loop to run the tasks on,
+//~   int gyroFreqHz; the gyrometer refresh frequency in Hz,
+//~   int odometryFreqHz; the odometry refresh frequency in Hz
+//~
+//~ output: void
+void robotPosition::updateCoordsTasks(eventLoop &loop, int gyroFreqHz,
+  int odometryFreqHz){
+
+  tasksLoop = &loop;
+  loop.spawn(updateAngleTask(loop, gyroFreqHz));
+  loop.spawn(updateXYTask(loop, odometryFreqHz));
+}// end function updateCoordsTasks
+#endif
+
+//~ Function: integrate
+//~ ----------------------------
+//~ Integrates recorded or buffered acquisitions in one call. The two
+//~   streams are merged by timestamp and each sample goes through
+//~   updateAngle or updateXY, under a single lock for the whole batch
+//~
+//~ input: std::span<const gyroSample> gyroSamples; the gyrometer samples,
+//~   std::span<const odometrySample> odometrySamples; the odometry
+//~   samples, both sorted by timestamp
+//~ inout: std::span<trajectoryPoint> poses; if not empty, the pose after
+//~   each sample is written there until it is full
+//~
+//~ output: size_t; the number of poses written
+size_t robotPosition::integrate(std::span<const gyroSample> gyroSamples,
+  std::span<const odometrySample> odometrySamples,
+  std::span<trajectoryPoint> poses){
+
+  return integrateSamples(gyroSamples, odometrySamples, poses);
+}// end function integrate
+
+//~ Function: integrate
+//~ ----------------------------
+//~ The same integration over the structs of dead_reckoning_c.h, read and
+//~   written in place in the caller's arrays
+//~
+//~ input: std::span<const deadReckoningGyroSample> gyroSamples; the
+//~   gyrometer samples, std::span<const deadReckoningOdometrySample>
+//~   odometrySamples; the odometry samples, both sorted by timestamp
+//~ inout: std::span<deadReckoningPose> poses; if not empty, the pose after
+//~   each sample is written there until it is full
+//~
+//~ output: size_t; the number of poses written
+size_t robotPosition::integrate(
+  std::span<const deadReckoningGyroSample> gyroSamples,
+  std::span<const deadReckoningOdometrySample> odometrySamples,
+  std::span<deadReckoningPose> poses){
+
+  return integrateSamples(gyroSamples, odometrySamples, poses);
+}// end function integrate
+
+//~ Function: getCoords
+//~ ----------------------------
+//~ Copies the coordinates, under the lock of the acquisition updates
+//~
+//~ inout: std::array<float, COORDS_SIZE> &coords; the returned
+//~   [x, y, tetha]
+//~
+//~ output: void
+void robotPosition::getCoords(std::array<float, COORDS_SIZE> &coords){
+#ifndef STATIC_POSITION
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  coords = floatCoords();
+}// end function getCoords
+
+//~ Function: saveState
+//~ ----------------------------
+//~ Copies the positioning state, for example to checkpoint it. The copy
+//~   is taken under the lock of the acquisition updates, so it can be
+//~   called from another thread while they run
+//~
+//~ inout: robotState &state; the returned state
+//~
+//~ output: void
+void robotPosition::saveState(robotState &state){
+#ifndef STATIC_POSITION
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  state.coords = floatCoords();
+  state.lastAngleUpdateMS = lastAngleUpdateMS;
+  state.lastXYUpdateMS = lastXYUpdateMS;
+  state.selfCalibration = selfCalibration;
+  calibrator.getState(state.calibration);
+}// end function saveState
+
+//~ Function: restoreState
+//~ ----------------------------
+//~ Resumes the positioning from a previously saved state
+//~
+//~ input: const robotState &state; the state to resume from
+//~
+//~ output: void
+void robotPosition::restoreState(const robotState &state){
+#ifndef STATIC_POSITION
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  coords = state.coords;
+  lastAngleUpdateMS = state.lastAngleUpdateMS;
+  lastXYUpdateMS = state.lastXYUpdateMS;
+  lastXYTetha = coords[2];
+  //the yaw rate before the restart is unknown, the next sample seeds it
+  hasYawRate = false;
+  lastYawRate = lastXYYawRate = 0;
+
+  //the wheels keep what they learned, a state without a calibration (a
+  //pose given by hand) starts from perfect wheels
+  selfCalibration = state.selfCalibration;
+  if (calibrator.setState(state.calibration) < 0){
+    calibrator = wheelCalibrator();
+  }
+  calibrationTetha = 0;
+  takeScales();
+#ifdef FIXED_POINT_POSITION
+  fixedCoords.x = fixedFromFloat(coords[0]);
+  fixedCoords.y = fixedFromFloat(coords[1]);
+  fixedCoords.tetha = binaryAngleFromRad(coords[2]);
+#endif
+}// end function restoreState
+
+//~ Function: setIntegration
+//~ ----------------------------
+//~ Selects how the x and y update moves between two odometry samples.
+//~   INTEGRATION_EULER, the default, goes straight along the last angle.
+//~   The others integrate the angle with the mean of two yaw rates and
+//~   move along: the mean angle of the interval for INTEGRATION_MIDPOINT,
+//~   the exact circle arc for INTEGRATION_ARC, or the angle quadratic in
+//~   time given by the interpolated yaw rates for INTEGRATION_RK4. It
+//~   takes the lock of the acquisition updates, so it can be called while
+//~   they run
+//~
+//~ input: int scheme; one of the INTEGRATION_ constants
+//~
+//~ output: int is 1 if suceess, -1 if the scheme is unknown or not
+//~   available in fixed point
+int robotPosition::setIntegration(int scheme){
+  if (scheme < INTEGRATION_EULER || scheme > INTEGRATION_RK4){
+    return -1;
+  }
+#ifdef FIXED_POINT_POSITION
+  //the fixed point path only moves along the last angle
+  if (scheme != INTEGRATION_EULER){
+    return -1;
+  }
+#endif
+
+#ifndef STATIC_POSITION
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  integration = scheme;
+  //the next x and y update starts from the current angle
+  lastXYTetha = coords[2];
+  lastXYYawRate = lastYawRate;
+
+  return 1;
+}// end function setIntegration
+
+//~ Function: setSelfCalibration
+//~ ----------------------------
+//~ Enables or disables the online calibration of the rear wheels. While
+//~   enabled, each odometry interval is compared with the angle seen by
+//~   the gyrometer and the estimated wheel scales correct the distances.
+//~   Enabling it starts from perfect wheels, disabling it goes back to
+//~   the raw distances. It takes the lock of the acquisition updates, so
+//~   it can be called while they run
+//~
+//~ input: bool enabled; true to calibrate, float trackWidth; the nominal
+//~   distance between the rear wheels in meters
+//~
+//~ output: void
+void robotPosition::setSelfCalibration(bool enabled, float trackWidth){
+#ifndef STATIC_POSITION
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  calibrator = wheelCalibrator(trackWidth);
+  calibrationTetha = 0;
+  takeScales();
+  selfCalibration = enabled;
+}// end function setSelfCalibration
+
+//~ Function: getCalibration
+//~ ----------------------------
+//~ Gets the current wheel calibration, under the lock of the
+//~   acquisition updates
+//~
+//~ inout: float &leftScale, float &rightScale; the factors applied to the
+//~   rear wheel distances, float &trackWidth; the effective track width
+//~   in meters
+//~
+//~ output: void
+void robotPosition::getCalibration(float &leftScale, float &rightScale,
+  float &trackWidth){
+
+#ifndef STATIC_POSITION
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  leftScale = this->leftScale;
+  rightScale = this->rightScale;
+  trackWidth = calibrator.getEffectiveTrackWidth();
+}// end function getCalibration
+
+//~ Function: setPoseSink
+//~ ----------------------------
+//~ Gives the pose after every x and y update to a function, for example
+//~   trajectoryEncoder::sink to compress the output. The function runs
+//~   on the acquisition thread under the update lock, so it must be
+//~   short and must not call the robotPosition back
+//~
+//~ input: poseSink sink; the function, NULL to remove it,
+//~   void *context; given back to the function
+//~
+//~ output: void
+void robotPosition::setPoseSink(poseSink sink, void *context){
+#ifndef STATIC_POSITION
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  this->sink = sink;
+  sinkContext = context;
+}// end function setPoseSink
+
+#ifndef STATIC_POSITION
+//~ Function: setAdaptiveRate
+//~ ----------------------------
+//~ Enables the adaptive rate: once the gyrometer and the odometry have
+//~   shown the robot still for a number of samples in a row, both loops
+//~   run at the idle frequency. The first sample showing motion brings
+//~   them back to their full frequency and wakes up the other loop. The
+//~   sensors are only read when a loop wakes up, so the motion is seen
+//~   up to one idle period (1/idleFreqHz, 500ms by default) after it
+//~   started. It can be called while the loops run
+//~
+//~ input: int idleFreqHz; the frequency of the loops while idle,
+//~   float stillYawRate; the yaw rate in rad/s under which the robot is
+//~   still, float stillSpeed; the wheel speed in m/s under which the robot
+//~   is still, int stillSamples; the number of still samples in a row
+//~   before going idle
+//~
+//~ output: void
+void robotPosition::setAdaptiveRate(int idleFreqHz, float stillYawRate,
+  float stillSpeed, int stillSamples){
+
+  this->idleFreqHz = idleFreqHz;
+  this->stillYawRate = stillYawRate;
+  this->stillSpeed = stillSpeed;
+  stillSamplesNeeded = stillSamples;
+  adaptiveRate = true;
+}// end function setAdaptiveRate
+
+//~ Function: getRateStats
+//~ ----------------------------
+//~ Gets the activity of the acquisition loops
+//~
+//~ inout: rateStats &stats; the returned statistics
+//~
+//~ output: void
+void robotPosition::getRateStats(rateStats &stats){
+  stats.gyroWakeups = gyroWakeups;
+  stats.odometryWakeups = odometryWakeups;
+  stats.toIdle = toIdle;
+  stats.toActive = toActive;
+  stats.idle = idle;
+  std::lock_guard<std::mutex> lock(rateMutex);
+  stats.sleeps = sleeps;
+  stats.totalLateNs = totalLateNs;
+  stats.maxLateNs = maxLateNs;
+}// end function getRateStats
+
+//~ Function: stopLoops
+//~ ----------------------------
+//~ Makes the acquisition loops return after their current iteration.
+//~   If updateCoordsTasks was used, it also stops the event loop the
+//~   tasks run on, so its run returns without waiting for their next
+//~   deadline
+//~
+//~ output: void
+void robotPosition::stopLoops(void){
+  std::lock_guard<std::mutex> lock(rateMutex);
+  running = false;
+  rateChanged.notify_all();
+
+  //the tasks sleep in the timers of the loop, they only see running once
+  //resumed
+  eventLoop *loop = tasksLoop;
+  if (loop != NULL){
+    loop->stop();
+  }
+}// end function stopLoops
+#endif
+
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 ///////////////////////////private methods//////////////////////////////
@@ -152,13 +540,13 @@ void robotPosition::updateXYLoop(int odometryFreqHz){
 //~ From the odometry and yaw rate data, it updates the yaw angle,
 //~   x and y position
 //~
-//~ input: std::array<float, 4> odometry; the odometry of the 4 wheels,
+//~ input: const std::array<float, 4> &odometry; the odometry of the 4 wheels,
 //~   uint32_t odometryTSMS; the time since the last odometry was took,
 //~   float yawRate; the yaw rate in rad/s, uint32_t yawRateTSMS; the
 //~   time since the last yaw rate was took.
 //~
 //~ output: void
-void robotPosition::updateCoords(std::array<float, 4> odometry,
+void robotPosition::updateCoords(const std::array<float, 4> &odometry,
   uint32_t odometryTSMS, float yawRate, uint32_t yawRateTSMS){
 
   //update the angle information
@@ -172,13 +560,29 @@ void robotPosition::updateCoords(std::array<float, 4> odometry,
 //~ ----------------------------
 //~ From the odometry data, it updates the x and y position
 //~
-//~ input: std::array<float, 4> odometry; the odometry of the 4 wheels,
+//~ input: const std::array<float, 4> &odometry; the odometry of the 4 wheels,
 //~   uint32_t odometryTSMS; the time since the last odometry was took.
 //~
 //~ output: void
-void robotPosition::updateXY(std::array<float, 4> odometry,
+void robotPosition::updateXY(const std::array<float, 4> &odometry,
   uint32_t odometryTSMS){
 
+#ifdef FIXED_POINT_POSITION
+  //the odometry gives floats, they are only converted on the way in
+  updateXYFixed({fixedFromFloat(odometry[0]), fixedFromFloat(odometry[1]),
+    fixedFromFloat(odometry[2]), fixedFromFloat(odometry[3])}, odometryTSMS);
+  return;
+#endif
+
+  if (selfCalibration){
+    calibrate(odometry);
+  }
+
+  if (integration != INTEGRATION_EULER){
+    integrateXY(coords, calculateDeltaDist(odometry), odometryTSMS);
+    return;
+  }
+
   //get the information from the last coordinates system
   std::array<float, XY_COORDS_SIZE> xyLastCoords = {coords[0], coords[1]};
   float tetha = coords[2];
@@ -206,10 +610,33 @@ void robotPosition::updateXY(std::array<float, 4> odometry,
 //~ output: void
 void robotPosition::updateAngle(float yawRate, uint32_t yawRateTSMS){
 
+#ifdef FIXED_POINT_POSITION
+  //the gyrometer gives a float, it is only converted on the way in
+  updateAngleFixed(binaryRateFromRad(yawRate), yawRateTSMS);
+  return;
+#endif
+
+  if (selfCalibration){
+    calibrationTetha += yawRate*yawRateTSMS/1000;
+  }
+
+  //the first sample after the construction or restoreState has no
+  //previous one to interpolate from
+  if (!hasYawRate){
+    hasYawRate = true;
+    lastYawRate = lastXYYawRate = yawRate;
+  }
+
+  //the schemes other than euler interpolate the yaw rate linearly between
+  //two samples, the angle then varies with their mean
+  float rate = integration == INTEGRATION_EULER ? yawRate :
+    MEAN(lastYawRate, yawRate);
+  lastYawRate = yawRate;
+
   //get the last coordinates
   float lastTetha = coords[2];
   //calculate the variation of angle
-  float deltaTetha = calculateDeltaTetha(yawRate, yawRateTSMS);
+  float deltaTetha = calculateDeltaTetha(rate, yawRateTSMS);
   //calculate the new angle
   float tetha = calculateTetha(deltaTetha, lastTetha);
 
@@ -217,81 +644,395 @@ void robotPosition::updateAngle(float yawRate, uint32_t yawRateTSMS){
   coords[2] = tetha;
 }// end function updateAngle
 
-//~ Function: calculateDeltaDist
+#ifdef FIXED_POINT_POSITION
+//~ Function: updateAngleFixed
 //~ ----------------------------
-//~ Calculates the variation in distance from the wheel odometry
+//~ The fixed point update of the angle, without any float unless the
+//~   self calibration is enabled. A gyrometer giving an integer rate
+//~   calls it directly
 //~
-//~ input: std::array<float, 4> odometry; the wheel odometry array organized
-//~   as following : [left_back, right_back, left_front, right_front]
+//~ input: int64_t yawRate; the yaw rate in binary angle units per second,
+//~   uint32_t yawRateTSMS; the time since the last yaw rate was took
 //~
-//~ output: float; distance draveled by the point in between the two rear wheels
-float robotPosition::calculateDeltaDist(std::array<float, 4> odometry){
-  return MEAN(odometry[0], odometry[1]);
-}// end function calculateDeltaDist
+//~ output: void
+void robotPosition::updateAngleFixed(int64_t yawRate, uint32_t yawRateTSMS){
+  if (selfCalibration){
+    calibrationTetha += radFromBinaryAngle(
+      (binaryAngle) (yawRate*yawRateTSMS/1000));
+  }
+
+  //the binary angle wraps around by itself, no fmod needed
+  fixedUpdateAngle(fixedCoords, yawRate, yawRateTSMS);
+}// end function updateAngleFixed
 
-//~ Function: calculateDeltaTetha
+//~ Function: updateXYFixed
 //~ ----------------------------
-//~ Calculates the variation of the direction with the yawRate and time
+//~ The fixed point update of x and y, without any float unless the self
+//~   calibration is enabled. An odometry giving integer distances calls
+//~   it directly
 //~
-//~ input: float yawRate; the yaw rate in rad/s, uint32_t deltaTMs; the time
-//~   difference between the last yawRate acquisition and the new one
+//~ input: const std::array<fixedQ16, 4> &odometry; the odometry of the 4
+//~   wheels in Q15.16, uint32_t odometryTSMS; the time since the last
+//~   odometry was took
 //~
-//~ output: float; angle difference between the last position and the new one
-float robotPosition::calculateDeltaTetha(float yawRate, uint32_t deltaTMs){
-  float deltaTS = (float) deltaTMs/1000;
-  return fmod(deltaTS*yawRate, 2*PI);
-}// end function calculateDeltaTetha
+//~ output: void
+void robotPosition::updateXYFixed(const std::array<fixedQ16, 4> &odometry,
+  uint32_t odometryTSMS){
+
+  if (selfCalibration){
+    calibrate({floatFromFixed(odometry[0]), floatFromFixed(odometry[1]),
+      floatFromFixed(odometry[2]), floatFromFixed(odometry[3])});
+  }
+
+  //the mean of the scaled rear wheels, rounded like fixedUpdateXY
+  const int64_t half = (int64_t) 1 << FIXED_POSITION_BITS;
+  fixedQ16 deltaDist = (fixedQ16) (((int64_t) fixedLeftScale*odometry[0] +
+    (int64_t) fixedRightScale*odometry[1] + half) >>
+    (FIXED_POSITION_BITS + 1));
 
-//~ Function: calculateTetha
+  //move along the binary angle with the table cosine and sine
+  fixedUpdateXY(fixedCoords, deltaDist);
+}// end function updateXYFixed
+#endif
+
+//~ Function: floatCoords
 //~ ----------------------------
-//~ Calculates the new angle between our x axis and the robot direction
+//~ Refreshes coords from the fixed point pose in that mode
 //~
-//~ input: float deltaTetha; the angle variation in rads, float lastTetha;
-//~   the angle between x axis and our robot at the last positon
+//~ output: const std::array<float, COORDS_SIZE> &; coords
+const std::array<float, COORDS_SIZE> &robotPosition::floatCoords(void){
+#ifdef FIXED_POINT_POSITION
+  coords[0] = floatFromFixed(fixedCoords.x);
+  coords[1] = floatFromFixed(fixedCoords.y);
+  coords[2] = radFromBinaryAngle(fixedCoords.tetha);
+#endif
+  return coords;
+}// end function floatCoords
+
+//~ Function: integrateXY
+//~ ----------------------------
+//~ Moves a pose with the selected scheme other than euler, from the angle
+//~   at the last x and y update to its current angle
 //~
-//~ output: float; angle between x axis and our robot's current position
-float robotPosition::calculateTetha(float deltaTetha, float lastTetha){
-  return fmod((deltaTetha + lastTetha), 2*PI);
-}// end function calculateTetha
+//~ inout: std::array<float, COORDS_SIZE> &pose; the pose updated
+//~ input: float deltaDist; the distance traveled, uint32_t deltaMS; the
+//~   time since the last x and y update
+//~
+//~ output: void
+void robotPosition::integrateXY(std::array<float, COORDS_SIZE> &pose,
+  float deltaDist, uint32_t deltaMS){
+
+  //the angle variation over the interval, unwrapped
+  float deltaTetha = remainder(pose[2] - lastXYTetha, 2*PI);
+  float tethaMid = lastXYTetha + deltaTetha/2;
+  float deltaX;
+  float deltaY;
+
+  if (integration == INTEGRATION_MIDPOINT){
+    deltaX = deltaDist*cos(tethaMid);
+    deltaY = deltaDist*sin(tethaMid);
+  }
+  else if (integration == INTEGRATION_ARC){
+    //on a circle arc the chord follows the mean angle and is shorter than
+    //the arc by sin(x)/x of the half angle
+    float half = deltaTetha/2;
+    float chord = fabs(half) < 0.001 ? 1 - half*half/6 : sin(half)/half;
+    deltaX = deltaDist*chord*cos(tethaMid);
+    deltaY = deltaDist*chord*sin(tethaMid);
+  }
+  else{
+    //with the yaw rate linear in time the angle is quadratic, the rk4 stages
+    //are the start, twice the middle and the end of the interval
+    float deltaTS = (float) deltaMS/1000;
+    float tethaHalf = tethaMid + (lastXYYawRate - lastYawRate)*deltaTS/8;
+    float tethaEnd = lastXYTetha + deltaTetha;
+    deltaX = deltaDist/6*(cos(lastXYTetha) + 4*cos(tethaHalf) +
+      cos(tethaEnd));
+    deltaY = deltaDist/6*(sin(lastXYTetha) + 4*sin(tethaHalf) +
+      sin(tethaEnd));
+  }
 
-//~ Function: calculateDeltaCoords
+  pose[0] += deltaX;
+  pose[1] += deltaY;
+  lastXYTetha = pose[2];
+  lastXYYawRate = lastYawRate;
+}// end function integrateXY
+
+//~ Function: integrateSamples
 //~ ----------------------------
-//~ Calculates the x and y shift on the abolute coordinate system
+//~ The merge behind both integrate, over the library or the C structs
 //~
-//~ input: float dist; distance traveled, float tetha;
-//~   the angle between x axis and our robot at the current positon
+//~ input: std::span<const gyroType> gyroSamples; the gyrometer samples,
+//~   std::span<const odometryType> odometrySamples; the odometry samples,
+//~   both sorted by timestamp
+//~ inout: std::span<poseType> poses; if not empty, the pose after each
+//~   sample is written there until it is full
 //~
-//~ output: std::array<float, XY_COORDS_SIZE>; the x and y shift as following:
-//~   [x, y]
-std::array<float, XY_COORDS_SIZE> robotPosition::calculateDeltaCoords
-  (float dist, float tetha){
+//~ output: size_t; the number of poses written
+template <typename gyroType, typename odometryType, typename poseType>
+size_t robotPosition::integrateSamples(std::span<const gyroType> gyroSamples,
+  std::span<const odometryType> odometrySamples, std::span<poseType> poses){
+
+
+#ifndef STATIC_POSITION
+  //the whole batch is one update for saveState
+  std::lock_guard<std::mutex> lock(stateMutex);
+#endif
+  size_t gyroIndex = 0;
+  size_t odometryIndex = 0;
+  size_t written = 0;
+
+  while (gyroIndex < gyroSamples.size() ||
+    odometryIndex < odometrySamples.size()){
 
-  std::array<float, XY_COORDS_SIZE> deltaCoords;
-  deltaCoords[0] = dist*cos(tetha);
-  deltaCoords[1] = dist*sin(tetha);
+    uint32_t timestamp;
+    //the oldest sample first, the difference survives the timestamp wrap
+    if (gyroIndex < gyroSamples.size() &&
+      (odometryIndex == odometrySamples.size() ||
+      (int32_t) (gyroSamples[gyroIndex].timestampMS -
+      odometrySamples[odometryIndex].timestampMS) <= 0)){
 
-  return deltaCoords;
-}// end function calculateDeltaCoords
+      const auto &sample = gyroSamples[gyroIndex++];
+      updateAngle(sample.yawRate,
+        sample.timestampMS - (uint32_t) lastAngleUpdateMS);
+      lastAngleUpdateMS = timestamp = sample.timestampMS;
+    }
+    else{
+      const auto &sample = odometrySamples[odometryIndex++];
+      updateXY(sampleOdometry(sample),
+        sample.timestampMS - (uint32_t) lastXYUpdateMS);
+      lastXYUpdateMS = timestamp = sample.timestampMS;
+      emitPose(timestamp);
+    }
 
-//~ Function: getAbsCoords
+    if (written < poses.size()){
+      writePose(poses[written++], timestamp, floatCoords());
+    }
+  }
+
+  return written;
+}// end function integrateSamples
+
+//~ Function: calibrate
 //~ ----------------------------
-//~ Calculates the current x and y on the absolute coordinate system
+//~ Gives an odometry interval and the angle seen by the gyrometer over it
+//~   to the calibration, then takes the new wheel scales
 //~
-//~ input: std::array<float, XY_COORDS_SIZE> deltaCoords; x and y shift from
-//~   the last position, std::array<float, XY_COORDS_SIZE> lastCoords; x and y
-//~   of the last position
+//~ input: const std::array<float, 4> &odometry; the raw odometry
 //~
-//~ output: std::array<float, XY_COORDS_SIZE>; x and y on the absolute
-//~   coordinate system as following: [x, y]
-std::array<float, XY_COORDS_SIZE> robotPosition::getAbsCoords(
-  std::array<float, XY_COORDS_SIZE> deltaCoords,
-  std::array<float, XY_COORDS_SIZE> lastCoords){
+//~ output: void
+void robotPosition::calibrate(const std::array<float, 4> &odometry){
+  calibrator.addSample(odometry[0], odometry[1], calibrationTetha);
+  calibrationTetha = 0;
+  takeScales();
+}// end function calibrate
 
-  std::array<float, XY_COORDS_SIZE> absCoords;
+//~ Function: takeScales
+//~ ----------------------------
+//~ Takes the wheel scales of the calibrator
+//~
+//~ output: void
+void robotPosition::takeScales(void){
+  calibrator.getScales(leftScale, rightScale);
+#ifdef FIXED_POINT_POSITION
+  fixedLeftScale = fixedFromFloat(leftScale);
+  fixedRightScale = fixedFromFloat(rightScale);
+#endif
+}// end function takeScales
 
-  for(int i = 0; i < XY_COORDS_SIZE; i++){
-    absCoords[i] = lastCoords[i] + deltaCoords[i];
+//~ Function: emitPose
+//~ ----------------------------
+//~ Gives the current pose to the sink if there is one
+//~
+//~ input: uint32_t timestampMS; the time of the pose
+//~
+//~ output: void
+void robotPosition::emitPose(uint32_t timestampMS){
+  if (sink != NULL){
+    sink(sinkContext, {timestampMS, floatCoords()});
   }
+}// end function emitPose
 
-  return absCoords;
-}// end function getAbsCoords
+#ifndef STATIC_POSITION
+//~ Function: updateMotion
+//~ ----------------------------
+//~ Switches between full and idle rate from the last sample of a loop
+//~
+//~ input: bool still; true if the sample shows the robot still
+//~
+//~ output: void
+void robotPosition::updateMotion(bool still){
+  if (!adaptiveRate){
+    return;
+  }
+
+  if (still){
+    //enough still samples in a row from both loops: slow down
+    if (++stillSamples >= stillSamplesNeeded && !idle.exchange(true)){
+      toIdle++;
+    }
+    return;
+  }
+
+  //any motion: back to full rate, waking up the loops sleeping idle
+  stillSamples = 0;
+  if (idle.exchange(false)){
+    std::lock_guard<std::mutex> lock(rateMutex);
+    toActive++;
+    rateChanged.notify_all();
+  }
+}// end function updateMotion
+
+//~ Function: loopPeriodMS
+//~ ----------------------------
+//~ Gives the period of a loop for the current rate
+//~
+//~ input: int freqHz; the full frequency of the loop in Hz
+//~
+//~ output: int; the period of the loop in miliseconds
+int robotPosition::loopPeriodMS(int freqHz){
+  int idleHz = idleFreqHz;
+  if (idle && idleHz < freqHz){
+    return 1000/idleHz;
+  }
+
+  return 1000/freqHz;
+}// end function loopPeriodMS
+
+//~ Function: waitPeriod
+//~ ----------------------------
+//~ Sleeps until the next iteration of a loop. With the adaptive rate, an
+//~   idle sleep is cut short when the robot starts moving
+//~
+//~ input: int sleepMS; the time to sleep in miliseconds
+//~
+//~ output: void
+void robotPosition::waitPeriod(int sleepMS){
+  if (sleepMS <= 0){
+    return;
+  }
+  auto end = std::chrono::steady_clock::now() +
+    std::chrono::milliseconds(sleepMS);
+  if (!adaptiveRate || !idle){
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleepMS));
+    std::lock_guard<std::mutex> lock(rateMutex);
+    countLateness(end);
+    return;
+  }
+
+  //an idle sleep is interrupted by the robot moving or a stop, it is only
+  //late if it was not
+  std::unique_lock<std::mutex> lock(rateMutex);
+  if (!rateChanged.wait_until(lock, end,
+    [this]{ return !idle || !running; })){
+
+    countLateness(end);
+  }
+}// end function waitPeriod
+
+//~ Function: countLateness
+//~ ----------------------------
+//~ Adds the lateness of a sleep to the rate stats, rateMutex held
+//~
+//~ input: std::chrono::steady_clock::time_point end; when the sleep
+//~   should have ended
+//~
+//~ output: void
+void robotPosition::countLateness(std::chrono::steady_clock::time_point end){
+  uint64_t lateNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - end).count();
+
+  sleeps++;
+  totalLateNs += lateNs;
+  maxLateNs = std::max(maxLateNs, lateNs);
+}// end function countLateness
+
+//~ Function: updateAngleTask
+//~ ----------------------------
+//~ The task that updates the angle from the gyrometer, see updateAngleLoop
+//~
+//~ input: eventLoop &loop; the loop it runs on,
+//~   int gyroFreqHz; the gyrometer refresh frequency in Hz
+//~
+//~ output: sensorTask; the task to spawn
+sensorTask robotPosition::updateAngleTask(eventLoop &loop, int gyroFreqHz){
+  float yawRate = 0.0;
+  uint32_t timestamp = 0;
+  uint64_t deadlineNs = eventLoop::nowNs();
+
+  while(running){
+    gyroWakeups++;
+    //the fusion is done inline, on the thread of the loop
+    if (gyrometerAcq(yawRate, timestamp) > 0){
+      {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        updateAngle(yawRate, timestamp - lastAngleUpdateMS);
+        lastAngleUpdateMS = timestamp;
+      }
+      updateMotion(fabs(yawRate) < stillYawRate);
+    }
+    deadlineNs = nextDeadline(deadlineNs, gyroFreqHz);
+    co_await loop.sleepUntil(deadlineNs);
+  }
+}// end function updateAngleTask
+
+//~ Function: updateXYTask
+//~ ----------------------------
+//~ The task that updates the x and y coordinates from the odometry, see
+//~   updateXYLoop
+//~
+//~ input: eventLoop &loop; the loop it runs on,
+//~   int odometryFreqHz; the odometry refresh frequency in Hz
+//~
+//~ output: sensorTask; the task to spawn
+sensorTask robotPosition::updateXYTask(eventLoop &loop, int odometryFreqHz){
+  std::array<float, 4> odometry = {0, 0, 0, 0};
+  uint32_t timestamp = 0;
+  uint32_t deltaMS = 0;
+  bool still = true;
+  uint64_t deadlineNs = eventLoop::nowNs();
+
+  while(running){
+    odometryWakeups++;
+    if (odometryAcq(odometry, timestamp) > 0){
+      {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        deltaMS = timestamp - lastXYUpdateMS;
+        updateXY(odometry, deltaMS);
+        lastXYUpdateMS = timestamp;
+        emitPose(timestamp);
+      }
+      //wheels all slower than the threshold show the robot still
+      still = true;
+      for (int i = 0; i < 4; i++){
+        still = still && fabs(odometry[i])*1000 <= stillSpeed*deltaMS;
+      }
+      updateMotion(still);
+    }
+    deadlineNs = nextDeadline(deadlineNs, odometryFreqHz);
+    co_await loop.sleepUntil(deadlineNs);
+  }
+}// end function updateXYTask
+
+//~ Function: nextDeadline
+//~ ----------------------------
+//~ Gives the next wakeup of a task, skipping the periods already missed
+//~
+//~ input: uint64_t deadlineNs; the last wakeup, int freqHz; the full
+//~   frequency of the task in Hz
+//~
+//~ output: uint64_t; the next wakeup, see eventLoop::nowNs
+uint64_t robotPosition::nextDeadline(uint64_t deadlineNs, int freqHz){
+  uint64_t periodNs = (uint64_t) loopPeriodMS(freqHz)*1000000;
+  uint64_t now = eventLoop::nowNs();
+
+  //the deadlines are absolute so the work does not delay the next one, but
+  //a late task does not burst to catch up with the periods it missed
+  deadlineNs += periodNs;
+  if (deadlineNs <= now){
+    deadlineNs += (now - deadlineNs)/periodNs*periodNs + periodNs;
+  }
+
+  return deadlineNs;
+}// end function nextDeadline
+#endif
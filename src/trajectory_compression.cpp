@@ -0,0 +1,387 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T13:02:47+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: trajectory_compression.cpp
+ * @Last modified time: 2026-10-19T13:02:47+02:00
+ */
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <cstring>
+
+#include "trajectory_compression.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////helpers//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: wrapAngle
+//~ ----------------------------
+//~ input: double angle; an angle in rads
+//~
+//~ output: double; the same angle in [-pi, pi]
+static double wrapAngle(double angle){
+  return angle - 2*PI*round(angle/(2*PI));
+}// end function wrapAngle
+
+//~ Function: interpolatePose
+//~ ----------------------------
+//~ Interpolates linearly in time between two poses, the angle turning the
+//~   shortest way. The encoder and the decoder must use the same one
+//~
+//~ input: const trajectoryPoint &start, const trajectoryPoint &end; the
+//~   poses around, uint32_t timestampMS; the time of the pose wanted
+//~ inout: std::array<double, COORDS_SIZE> &pose; the returned pose
+//~
+//~ output: void
+static void interpolatePose(const trajectoryPoint &start,
+  const trajectoryPoint &end, uint32_t timestampMS,
+  std::array<double, COORDS_SIZE> &pose){
+
+  double ratio = 0;
+  if (end.timestampMS != start.timestampMS){
+    ratio = (double) (timestampMS - start.timestampMS)/
+      (end.timestampMS - start.timestampMS);
+  }
+
+  pose[0] = start.pose[0] + ratio*(end.pose[0] - start.pose[0]);
+  pose[1] = start.pose[1] + ratio*(end.pose[1] - start.pose[1]);
+  pose[2] = start.pose[2] + ratio*wrapAngle(end.pose[2] - start.pose[2]);
+}// end function interpolatePose
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////constructor destructor///////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+trajectoryEncoder::trajectoryEncoder(float maxXYError, float maxTethaError,
+  size_t windowSize){
+
+  maxXY = maxXYError;
+  maxTetha = maxTethaError;
+  //the quantization alone stays under half a step on each axis, so
+  //0.354*maxXY in position and 0.5*maxTetha, the rest is checked against
+  //the dequantized key poses
+  xyStep = maxXYError/2;
+  tethaStep = maxTethaError;
+  window = windowSize < 1 ? 1 : windowSize;
+  pending.reserve(window);
+
+  bytes.resize(COMPRESSION_HEADER_SIZE);
+  memcpy(&bytes[0], &xyStep, sizeof(float));
+  memcpy(&bytes[sizeof(float)], &tethaStep, sizeof(float));
+}
+
+trajectoryEncoder::~trajectoryEncoder(void){
+}
+
+trajectoryDecoder::trajectoryDecoder(void){
+}
+
+trajectoryDecoder::~trajectoryDecoder(void){
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////public methods///////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: addPose
+//~ ----------------------------
+//~ Adds the next pose of the trajectory, timestamps must not decrease
+//~
+//~ input: uint32_t timestampMS; the time of the pose in miliseconds,
+//~   std::array<float, COORDS_SIZE> pose; the pose as [x, y, tetha]
+//~
+//~ output: void
+void trajectoryEncoder::addPose(uint32_t timestampMS,
+  std::array<float, COORDS_SIZE> pose){
+
+  trajectoryPoint point = {timestampMS, pose};
+  std::array<int64_t, COORDS_SIZE + 1> quantized;
+  trajectoryPoint candidate;
+
+  poseCount++;
+  //the first pose is always a key pose
+  if (!hasAnchor){
+    writeKeyPose(point);
+    return;
+  }
+
+  //extend the current segment up to this pose if the dropped ones still fit
+  quantize(point, quantized, candidate);
+  if (pending.size() < window && segmentFits(candidate)){
+    pending.push_back(point);
+    return;
+  }
+
+  //otherwise the segment ends on the previous pose, which becomes a key pose
+  writeKeyPose(pending.back());
+  pending.clear();
+  pending.push_back(point);
+}// end function addPose
+
+//~ Function: flush
+//~ ----------------------------
+//~ Writes the last pose received as a key pose, to call at the end of the
+//~   trajectory
+//~
+//~ output: void
+void trajectoryEncoder::flush(void){
+  if (!pending.empty()){
+    writeKeyPose(pending.back());
+    pending.clear();
+  }
+}// end function flush
+
+//~ Function: getBytes
+//~ ----------------------------
+//~ output: const std::vector<uint8_t> &; the encoded stream so far
+const std::vector<uint8_t> &trajectoryEncoder::getBytes(void){
+  return bytes;
+}// end function getBytes
+
+//~ Function: poses
+//~ ----------------------------
+//~ output: uint64_t; the number of poses received
+uint64_t trajectoryEncoder::poses(void){
+  return poseCount;
+}// end function poses
+
+//~ Function: keyPoses
+//~ ----------------------------
+//~ output: uint64_t; the number of key poses written
+uint64_t trajectoryEncoder::keyPoses(void){
+  return keyCount;
+}// end function keyPoses
+
+//~ Function: sink
+//~ ----------------------------
+//~ The poseSink that compresses the output of a robotPosition:
+//~   robot_position.setPoseSink(trajectoryEncoder::sink, &encoder)
+//~
+//~ input: void *encoder; the trajectoryEncoder,
+//~   const trajectoryPoint &point; the pose to add
+//~
+//~ output: void
+void trajectoryEncoder::sink(void *encoder, const trajectoryPoint &point){
+  static_cast<trajectoryEncoder *>(encoder)->addPose(point.timestampMS,
+    point.pose);
+}// end function sink
+
+//~ Function: decode
+//~ ----------------------------
+//~ Decodes all the key poses of a stream
+//~
+//~ input: const uint8_t *data; the stream, size_t size; its size in bytes
+//~ inout: std::vector<trajectoryPoint> &keyPoints; cleared then filled
+//~   with the key poses
+//~
+//~ output: int is 1 if suceess, -1 if the stream is truncated or invalid
+int trajectoryDecoder::decode(const uint8_t *data, size_t size,
+  std::vector<trajectoryPoint> &keyPoints){
+
+  float xyStep;
+  float tethaStep;
+  std::array<int64_t, COORDS_SIZE + 1> quantized = {0, 0, 0, 0};
+  size_t offset = COMPRESSION_HEADER_SIZE;
+
+  keyPoints.clear();
+  if (size < COMPRESSION_HEADER_SIZE){
+    return -1;
+  }
+  memcpy(&xyStep, &data[0], sizeof(float));
+  memcpy(&tethaStep, &data[sizeof(float)], sizeof(float));
+
+  //each key pose is the difference with the previous one
+  while (offset < size){
+    for (int i = 0; i < COORDS_SIZE + 1; i++){
+      int64_t delta;
+      if (readVarint(data, size, offset, delta) < 0){
+        return -1;
+      }
+      quantized[i] += delta;
+    }
+    keyPoints.push_back({(uint32_t) quantized[0], {quantized[1]*xyStep,
+      quantized[2]*xyStep, quantized[3]*tethaStep}});
+  }
+
+  return 1;
+}// end function decode
+
+//~ Function: getPose
+//~ ----------------------------
+//~ Interpolates the pose at a given time between the key poses
+//~
+//~ input: const std::vector<trajectoryPoint> &keyPoints; the decoded key
+//~   poses, uint32_t timestampMS; the time of the pose wanted
+//~ inout: std::array<float, COORDS_SIZE> &pose; the returned pose
+//~
+//~ output: int is 1 if suceess, -1 if the time is outside the trajectory
+int trajectoryDecoder::getPose(const std::vector<trajectoryPoint> &keyPoints,
+  uint32_t timestampMS, std::array<float, COORDS_SIZE> &pose){
+
+  std::array<double, COORDS_SIZE> interpolated;
+
+  if (keyPoints.empty() || timestampMS < keyPoints.front().timestampMS ||
+    timestampMS > keyPoints.back().timestampMS){
+    return -1;
+  }
+
+  //find the first key pose at or after the time wanted
+  size_t low = 0;
+  size_t high = keyPoints.size() - 1;
+  while (low < high){
+    size_t middle = (low + high)/2;
+    if (keyPoints[middle].timestampMS < timestampMS){
+      low = middle + 1;
+    }
+    else{
+      high = middle;
+    }
+  }
+
+  if (low == 0){
+    pose = keyPoints[0].pose;
+    return 1;
+  }
+  interpolatePose(keyPoints[low - 1], keyPoints[low], timestampMS,
+    interpolated);
+  for (int i = 0; i < COORDS_SIZE; i++){
+    pose[i] = interpolated[i];
+  }
+
+  return 1;
+}// end function getPose
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////private methods//////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: quantize
+//~ ----------------------------
+//~ Quantizes a pose to the steps of the stream
+//~
+//~ input: const trajectoryPoint &point; the pose
+//~ inout: std::array<int64_t, COORDS_SIZE + 1> &quantized; the returned
+//~   [timestamp, x, y, tetha] in steps, trajectoryPoint &dequantized; the
+//~   pose as the decoder will read it
+//~
+//~ output: void
+void trajectoryEncoder::quantize(const trajectoryPoint &point,
+  std::array<int64_t, COORDS_SIZE + 1> &quantized,
+  trajectoryPoint &dequantized){
+
+  quantized[0] = point.timestampMS;
+  quantized[1] = llround(point.pose[0]/xyStep);
+  quantized[2] = llround(point.pose[1]/xyStep);
+  quantized[3] = llround(point.pose[2]/tethaStep);
+
+  dequantized.timestampMS = point.timestampMS;
+  dequantized.pose = {quantized[1]*xyStep, quantized[2]*xyStep,
+    quantized[3]*tethaStep};
+}// end function quantize
+
+//~ Function: segmentFits
+//~ ----------------------------
+//~ Checks that all the pending poses are close enough to the segment from
+//~   the last key pose to a candidate key pose
+//~
+//~ input: const trajectoryPoint &end; the candidate key pose, dequantized
+//~
+//~ output: bool; true if no pending pose is farther than the errors
+bool trajectoryEncoder::segmentFits(const trajectoryPoint &end){
+  std::array<double, COORDS_SIZE> interpolated;
+
+  //the candidate itself is not checked, it only suffers from the quantization
+  for (const trajectoryPoint &point : pending){
+    interpolatePose(anchor, end, point.timestampMS, interpolated);
+    double dx = point.pose[0] - interpolated[0];
+    double dy = point.pose[1] - interpolated[1];
+    if (dx*dx + dy*dy > maxXY*maxXY ||
+      fabs(wrapAngle(point.pose[2] - interpolated[2])) > maxTetha){
+      return false;
+    }
+  }
+
+  return true;
+}// end function segmentFits
+
+//~ Function: writeKeyPose
+//~ ----------------------------
+//~ Writes a key pose at the end of the stream
+//~
+//~ input: const trajectoryPoint &point; the key pose
+//~
+//~ output: void
+void trajectoryEncoder::writeKeyPose(const trajectoryPoint &point){
+  std::array<int64_t, COORDS_SIZE + 1> quantized;
+  std::array<int64_t, COORDS_SIZE + 1> previous = {0, 0, 0, 0};
+
+  if (hasAnchor){
+    previous = anchorQ;
+  }
+  quantize(point, quantized, anchor);
+  for (int i = 0; i < COORDS_SIZE + 1; i++){
+    writeVarint(quantized[i] - previous[i]);
+  }
+
+  anchorQ = quantized;
+  hasAnchor = true;
+  keyCount++;
+}// end function writeKeyPose
+
+//~ Function: writeVarint
+//~ ----------------------------
+//~ Writes a signed integer on as few bytes as possible, 7 bits per byte
+//~
+//~ input: int64_t value; the integer
+//~
+//~ output: void
+void trajectoryEncoder::writeVarint(int64_t value){
+  //zigzag: small negative values also get small codes
+  uint64_t code = ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+
+  while (code >= 0x80){
+    bytes.push_back((uint8_t) (code | 0x80));
+    code >>= 7;
+  }
+  bytes.push_back((uint8_t) code);
+}// end function writeVarint
+
+//~ Function: readVarint
+//~ ----------------------------
+//~ Reads a signed integer written by writeVarint
+//~
+//~ input: const uint8_t *data, size_t size; the stream
+//~ inout: size_t &offset; the position in the stream, moved after the
+//~   integer, int64_t &value; the returned integer
+//~
+//~ output: int is 1 if suceess, -1 if the stream is truncated
+int trajectoryDecoder::readVarint(const uint8_t *data, size_t size,
+  size_t &offset, int64_t &value){
+
+  uint64_t code = 0;
+
+  for (int shift = 0; shift < 64; shift += 7){
+    if (offset >= size){
+      return -1;
+    }
+    uint8_t byte = data[offset++];
+    code |= (uint64_t) (byte & 0x7F) << shift;
+    if (!(byte & 0x80)){
+      value = (int64_t) (code >> 1) ^ -(int64_t) (code & 1);
+      return 1;
+    }
+  }
+
+  return -1;
+}// end function readVarint
@@ -0,0 +1,146 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T18:36:52+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: wheel_calibration.cpp
+ * @Last modified time: 2026-10-19T18:36:52+02:00
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "wheel_calibration.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////constructor destructor///////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+wheelCalibrator::wheelCalibrator(float trackWidth, double forgetting){
+  width = trackWidth;
+  lambda = forgetting;
+
+  //start from perfect wheels
+  right = 1/width;
+  left = 1/width;
+  iRR = 1/CALIBRATION_VARIANCE;
+  iRL = 0;
+  iLL = 1/CALIBRATION_VARIANCE;
+}
+
+wheelCalibrator::~wheelCalibrator(void){
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////public methods///////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Function: addSample
+//~ ----------------------------
+//~ Updates the estimates with one odometry interval
+//~
+//~ input: float leftDist, float rightDist; the distances given by the
+//~   rear wheels, float deltaTetha; the angle variation measured by the
+//~   gyrometer over the same interval
+//~
+//~ output: int is 1 if the sample was used, -1 if the robot did not move
+int wheelCalibrator::addSample(float leftDist, float rightDist,
+  float deltaTetha){
+
+  //a still robot only shows the gyrometer bias
+  if (fabs(leftDist) + fabs(rightDist) < CALIBRATION_MIN_DIST){
+    return -1;
+  }
+
+  //deltaTetha = right*rightDist + left*(-leftDist)
+  double phiR = rightDist;
+  double phiL = -leftDist;
+
+  //forget a part 1 - lambda of the information along the direction the
+  //sample excites, the other directions keep theirs so their variance
+  //never grows. Along the excited one the information settles at about
+  //phi^2/(1 - lambda)
+  double iPhiR = iRR*phiR + iRL*phiL;
+  double iPhiL = iRL*phiR + iLL*phiL;
+  double forget = (1 - lambda)/(phiR*iPhiR + phiL*iPhiL);
+  iRR += phiR*phiR - forget*iPhiR*iPhiR;
+  iRL += phiR*phiL - forget*iPhiR*iPhiL;
+  iLL += phiL*phiL - forget*iPhiL*iPhiL;
+
+  //the gain is the covariance times phi, with the 2x2 inverse
+  double det = iRR*iLL - iRL*iRL;
+  double error = deltaTetha - (right*phiR + left*phiL);
+  right += (iLL*phiR - iRL*phiL)/det*error;
+  left += (iRR*phiL - iRL*phiR)/det*error;
+  count++;
+
+  return 1;
+}// end function addSample
+
+//~ Function: getScales
+//~ ----------------------------
+//~ Gets the factors to apply to the wheel distances, bounded by
+//~   CALIBRATION_MAX_CORRECTION
+//~
+//~ inout: float &leftScale, float &rightScale; the returned factors
+//~
+//~ output: void
+void wheelCalibrator::getScales(float &leftScale, float &rightScale){
+  leftScale = std::clamp(left*width, 1 - CALIBRATION_MAX_CORRECTION,
+    1 + CALIBRATION_MAX_CORRECTION);
+  rightScale = std::clamp(right*width, 1 - CALIBRATION_MAX_CORRECTION,
+    1 + CALIBRATION_MAX_CORRECTION);
+}// end function getScales
+
+//~ Function: getEffectiveTrackWidth
+//~ ----------------------------
+//~ output: float; the track width in meters that explains the rotations
+//~   with the uncorrected wheel distances
+float wheelCalibrator::getEffectiveTrackWidth(void){
+  return 2/(right + left);
+}// end function getEffectiveTrackWidth
+
+//~ Function: samples
+//~ ----------------------------
+//~ output: uint64_t; the number of samples used
+uint64_t wheelCalibrator::samples(void){
+  return count;
+}// end function samples
+
+//~ Function: getState
+//~ ----------------------------
+//~ inout: calibrationState &state; the returned estimates
+//~
+//~ output: void
+void wheelCalibrator::getState(calibrationState &state){
+  state = {width, right, left, iRR, iRL, iLL, count};
+}// end function getState
+
+//~ Function: setState
+//~ ----------------------------
+//~ Resumes from estimates given by getState
+//~
+//~ input: const calibrationState &state; the estimates
+//~
+//~ output: int is 1 if suceess, -1 if the track width is not positive or
+//~   the information matrix not positive definite, nothing changes then
+int wheelCalibrator::setState(const calibrationState &state){
+  if (!(state.trackWidth > 0) || !(state.iRR > 0) ||
+    !(state.iRR*state.iLL - state.iRL*state.iRL > 0)){
+
+    return -1;
+  }
+
+  width = state.trackWidth;
+  right = state.right;
+  left = state.left;
+  iRR = state.iRR;
+  iRL = state.iRL;
+  iLL = state.iLL;
+  count = state.count;
+
+  return 1;
+}// end function setState
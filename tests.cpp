@@ -8,11 +8,29 @@
 
 
 
-#define private public
-
 #include <thread>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <functional>
+#include <cstdio>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+
+//after the standard headers, the C++20 ones do not build with it
+#define private public
 
 #include "position_library.h"
+#include "fleet_index.h"
+#include "pose_checkpoint.h"
+#include "pose_smoother.h"
+#include "trajectory_compression.h"
+#include "fixed_point.h"
+#include "static_position.h"
+#include "wheel_calibration.h"
+#include "event_loop.h"
 
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
@@ -25,6 +43,48 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 
+#ifdef __GLIBC__
+//the glibc allocator, the hooks below count the calls then forward them
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+#endif
+
+//the number of heap allocations done while countAllocations is true, new
+//ends in malloc too
+static bool countAllocations = false;
+static long allocations = 0;
+
+#ifdef __GLIBC__
+extern "C" void *malloc(size_t size){
+  if (countAllocations){
+    allocations++;
+  }
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size){
+  if (countAllocations){
+    allocations++;
+  }
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size){
+  if (countAllocations){
+    allocations++;
+  }
+  return __libc_realloc(pointer, size);
+}
+#endif
+
+//the pose through getCoords, in fixed point coords is only refreshed there
+static std::array<float, COORDS_SIZE> poseOf(robotPosition &position){
+  std::array<float, COORDS_SIZE> coords;
+  position.getCoords(coords);
+  return coords;
+}
+
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////test group//////////////////////////////////
@@ -53,6 +113,205 @@ TEST_GROUP(robustness_tests)
    }
 };
 
+TEST_GROUP(fleet_tests)
+{
+  fleetPoses fleet_poses;
+  std::vector<uint32_t> cartIds;
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+};
+
+TEST_GROUP(checkpoint_tests)
+{
+  robotPosition robot_position;
+  poseCheckpoint checkpoint;
+  const char *path = "build/tests_checkpoint.ckpt";
+  void setup()
+   {
+     remove(path);
+   }
+   void teardown()
+   {
+     checkpoint.closeFile();
+     remove(path);
+   }
+};
+
+TEST_GROUP(smoother_tests)
+{
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+};
+
+TEST_GROUP(compression_tests)
+{
+  trajectoryDecoder decoder;
+  std::vector<trajectoryPoint> keyPoints;
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+};
+
+TEST_GROUP(adaptive_rate_tests)
+{
+  robotPosition robot_position;
+  rateStats stats;
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+};
+
+TEST_GROUP(fixed_point_tests)
+{
+  robotPosition robot_position;
+  fixedPose pose = {0, 0, 0};
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+};
+
+TEST_GROUP(static_position_tests)
+{
+  staticPosition<8, 8> static_position;
+  robotPosition robot_position;
+  std::array<float, COORDS_SIZE> coords;
+  void setup()
+   {
+   }
+   void teardown()
+   {
+     countAllocations = false;
+   }
+};
+
+TEST_GROUP(batch_tests)
+{
+  robotPosition robot_position;
+  robotPosition batch_position;
+  std::vector<gyroSample> gyroSamples;
+  std::vector<odometrySample> odometrySamples;
+  void setup()
+   {
+     //100Hz gyrometer and 50Hz odometry, shifted by 3ms
+     for (uint32_t i = 1; i <= 2000; i++){
+       gyroSamples.push_back({(float) (0.6*sin(i*0.01)), i*10});
+     }
+     for (uint32_t i = 1; i <= 1000; i++){
+       float left = 0.01 + 0.004*cos(i*0.02);
+       odometrySamples.push_back({{left, 0.02f - left, left, 0.02f - left},
+         i*20 + 3});
+     }
+   }
+   void teardown()
+   {
+   }
+};
+
+TEST_GROUP(integration_tests)
+{
+  robotPosition robot_position;
+  std::vector<gyroSample> gyroSamples;
+  std::vector<odometrySample> odometrySamples;
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+  //samples a 20 second circle at 1m/s and 0.5rad/s, returns the error of
+  //the final position
+  double circleError(int scheme, uint32_t periodMS){
+    for (uint32_t t = 0; t <= 20000; t += periodMS){
+      float dist = t == 0 ? 0 : periodMS/1000.0;
+      gyroSamples.push_back({0.5, t});
+      odometrySamples.push_back({{dist, dist, dist, dist}, t});
+    }
+    robot_position.setIntegration(scheme);
+    robot_position.integrate(gyroSamples, odometrySamples);
+    return hypot(poseOf(robot_position)[0] - sin(0.5*20)/0.5,
+      poseOf(robot_position)[1] - (1 - cos(0.5*20))/0.5);
+  }
+};
+
+TEST_GROUP(calibration_tests)
+{
+  wheelCalibrator calibrator;
+  robotPosition calibrated_position;
+  robotPosition raw_position;
+  float leftScale;
+  float rightScale;
+  float trackWidth;
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+};
+
+TEST_GROUP(event_loop_tests)
+{
+  eventLoop loop;
+  eventLoopStats stats;
+  std::vector<int> order;
+  int resumes = 0;
+  int foreignResumes = 0;
+  void setup()
+   {
+   }
+   void teardown()
+   {
+   }
+
+  //a task that sleeps then records its number
+  sensorTask sleeper(int id, int sleepMS){
+    co_await loop.sleepUntil(eventLoop::nowNs() + sleepMS*1000000ULL);
+    order.push_back(id);
+  }
+
+  //a task that waits for a byte on a file descriptor
+  sensorTask reader(int fd, char &value){
+    int ready = co_await loop.readable(fd);
+    if (ready > 0){
+      (void) !read(fd, &value, 1);
+    }
+  }
+
+  //a task that writes a byte on a file descriptor after a while
+  sensorTask writer(int fd, char value){
+    co_await loop.sleepUntil(eventLoop::nowNs() + 10000000);
+    (void) !write(fd, &value, 1);
+  }
+
+  //a periodic source that checks which thread resumes it
+  sensorTask periodic(std::thread::id thread, int periods){
+    uint64_t deadlineNs = eventLoop::nowNs();
+    for (int i = 0; i < periods; i++){
+      deadlineNs += 2000000;
+      co_await loop.sleepUntil(deadlineNs);
+      resumes++;
+      foreignResumes += std::this_thread::get_id() != thread;
+    }
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 ////////////////////functionnal test functions//////////////////////////
@@ -301,9 +560,9 @@ TEST(functional_tests, getAbsCoordsNegativeLast){
 //~
 //~
 TEST(functional_tests, updateCoordsTest){
-  DOUBLES_EQUAL(0, robot_position.coords[0], 0.000001);
-  DOUBLES_EQUAL(0, robot_position.coords[1], 0.000001);
-  DOUBLES_EQUAL(0, robot_position.coords[2], 0.000001);
+  DOUBLES_EQUAL(0, poseOf(robot_position)[0], 0.000001);
+  DOUBLES_EQUAL(0, poseOf(robot_position)[1], 0.000001);
+  DOUBLES_EQUAL(0, poseOf(robot_position)[2], 0.000001);
 
   std::array<float, 4> odometry = {1, 1, 1, 1};
   uint32_t odometryTSMS = 500;
@@ -312,9 +571,9 @@ TEST(functional_tests, updateCoordsTest){
 
   robot_position.updateCoords(odometry, odometryTSMS, yawRate, yawRateTSMS);
 
-  DOUBLES_EQUAL(1, robot_position.coords[0], 0.000001);
-  DOUBLES_EQUAL(0, robot_position.coords[1], 0.000001);
-  DOUBLES_EQUAL(0, robot_position.coords[2], 0.000001);
+  DOUBLES_EQUAL(1, poseOf(robot_position)[0], 0.000001);
+  DOUBLES_EQUAL(0, poseOf(robot_position)[1], 0.000001);
+  DOUBLES_EQUAL(0, poseOf(robot_position)[2], 0.000001);
 
   odometry = {0.587, 0.413, 0.587, 0.413};
   odometryTSMS = 500;
@@ -323,9 +582,9 @@ TEST(functional_tests, updateCoordsTest){
 
   robot_position.updateCoords(odometry, odometryTSMS, yawRate, yawRateTSMS);
 
-  DOUBLES_EQUAL(1.4924, robot_position.coords[0], 0.0001);
-  DOUBLES_EQUAL(0.0868, robot_position.coords[1], 0.0001);
-  DOUBLES_EQUAL(0.1745, robot_position.coords[2], 0.0001);
+  DOUBLES_EQUAL(1.4924, poseOf(robot_position)[0], 0.0001);
+  DOUBLES_EQUAL(0.0868, poseOf(robot_position)[1], 0.0001);
+  DOUBLES_EQUAL(0.1745, poseOf(robot_position)[2], 0.0001);
 
   odometry = {1, 1, 1, 1};
   odometryTSMS = 500;
@@ -334,9 +593,9 @@ TEST(functional_tests, updateCoordsTest){
 
   robot_position.updateCoords(odometry, odometryTSMS, yawRate, yawRateTSMS);
 
-  DOUBLES_EQUAL(1.4924, robot_position.coords[0], 0.0001);
-  DOUBLES_EQUAL(1.0868, robot_position.coords[1], 0.0001);
-  DOUBLES_EQUAL(PI/2, robot_position.coords[2], 0.0001);
+  DOUBLES_EQUAL(1.4924, poseOf(robot_position)[0], 0.0001);
+  DOUBLES_EQUAL(1.0868, poseOf(robot_position)[1], 0.0001);
+  DOUBLES_EQUAL(PI/2, poseOf(robot_position)[2], 0.0001);
 
   odometry = {1.42, 1.42, 1.42, 1.42};
   odometryTSMS = 500;
@@ -345,9 +604,9 @@ TEST(functional_tests, updateCoordsTest){
 
   robot_position.updateCoords(odometry, odometryTSMS, yawRate, yawRateTSMS);
 
-  DOUBLES_EQUAL(2.9124, robot_position.coords[0], 0.0001);
-  DOUBLES_EQUAL(1.0868, robot_position.coords[1], 0.0001);
-  DOUBLES_EQUAL(0, robot_position.coords[2], 0.0001);
+  DOUBLES_EQUAL(2.9124, poseOf(robot_position)[0], 0.0001);
+  DOUBLES_EQUAL(1.0868, poseOf(robot_position)[1], 0.0001);
+  DOUBLES_EQUAL(0, poseOf(robot_position)[2], 0.0001);
 
   odometry = {0.0255, 0.375, 0.0255, 0.375};
   odometryTSMS = 500;
@@ -356,9 +615,9 @@ TEST(functional_tests, updateCoordsTest){
 
   robot_position.updateCoords(odometry, odometryTSMS, yawRate, yawRateTSMS);
 
-  DOUBLES_EQUAL(3.1005, robot_position.coords[0], 0.0001);
-  DOUBLES_EQUAL(1.0183, robot_position.coords[1], 0.0001);
-  DOUBLES_EQUAL(-0.3490, robot_position.coords[2], 0.0001);
+  DOUBLES_EQUAL(3.1005, poseOf(robot_position)[0], 0.0001);
+  DOUBLES_EQUAL(1.0183, poseOf(robot_position)[1], 0.0001);
+  DOUBLES_EQUAL(-0.3490, poseOf(robot_position)[2], 0.0001);
 
   odometry = {1, -1, 1, -1};
   odometryTSMS = 500;
@@ -367,9 +626,9 @@ TEST(functional_tests, updateCoordsTest){
 
   robot_position.updateCoords(odometry, odometryTSMS, yawRate, yawRateTSMS);
 
-  DOUBLES_EQUAL(3.1005, robot_position.coords[0], 0.0001);
-  DOUBLES_EQUAL(1.0183, robot_position.coords[1], 0.0001);
-  DOUBLES_EQUAL(-0.3490, robot_position.coords[2], 0.0001);
+  DOUBLES_EQUAL(3.1005, poseOf(robot_position)[0], 0.0001);
+  DOUBLES_EQUAL(1.0183, poseOf(robot_position)[1], 0.0001);
+  DOUBLES_EQUAL(-0.3490, poseOf(robot_position)[2], 0.0001);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -402,6 +661,1082 @@ TEST(robustness_tests, calculateTethaOver2pi){
   DOUBLES_EQUAL(PI, tetha, 0.000001);
 }
 
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////fleet index test functions///////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fleet_tests, radiusQueryAcrossCells){
+  fleet_poses.updatePose(1, {0.5, 0.5, 0});
+  fleet_poses.updatePose(2, {2.1, 0.5, 0});
+  fleet_poses.updatePose(3, {-1.0, -1.0, 0});
+  fleet_poses.updatePose(4, {10, 10, 0});
+
+  LONGS_EQUAL(3, fleet_poses.radiusQuery({0.5, 0.5}, 2.2, cartIds));
+  std::sort(cartIds.begin(), cartIds.end());
+  LONGS_EQUAL(1, cartIds[0]);
+  LONGS_EQUAL(2, cartIds[1]);
+  LONGS_EQUAL(3, cartIds[2]);
+  LONGS_EQUAL(1, fleet_poses.radiusQuery({10, 10}, 0.1, cartIds));
+  LONGS_EQUAL(4, cartIds[0]);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fleet_tests, updatePoseMovesCart){
+  fleet_poses.updatePose(1, {0.5, 0.5, 0});
+  fleet_poses.updatePose(1, {20.5, -7.5, 1});
+
+  LONGS_EQUAL(1, fleet_poses.size());
+  LONGS_EQUAL(0, fleet_poses.radiusQuery({0.5, 0.5}, 1, cartIds));
+  LONGS_EQUAL(1, fleet_poses.zoneQuery({20, -8}, {21, -7}, cartIds));
+
+  std::array<float, COORDS_SIZE> pose;
+  CHECK(fleet_poses.getPose(1, pose));
+  DOUBLES_EQUAL(20.5, pose[0], 0.000001);
+  DOUBLES_EQUAL(-7.5, pose[1], 0.000001);
+  DOUBLES_EQUAL(1, pose[2], 0.000001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fleet_tests, removeCartKeepsOthers){
+  fleet_poses.updatePose(1, {0.5, 0.5, 0});
+  fleet_poses.updatePose(2, {0.6, 0.6, 0});
+  fleet_poses.updatePose(3, {5, 5, 0});
+
+  CHECK(fleet_poses.removeCart(1));
+  CHECK(!fleet_poses.removeCart(1));
+  LONGS_EQUAL(2, fleet_poses.size());
+  LONGS_EQUAL(1, fleet_poses.radiusQuery({0.5, 0.5}, 1, cartIds));
+  LONGS_EQUAL(2, cartIds[0]);
+  LONGS_EQUAL(1, fleet_poses.radiusQuery({5, 5}, 1, cartIds));
+  LONGS_EQUAL(3, cartIds[0]);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fleet_tests, kNearestMatchesBruteForce){
+  std::array<float, XY_COORDS_SIZE> center = {3.3, -1.7};
+  std::vector<std::pair<float, uint32_t>> expected;
+
+  for (uint32_t id = 0; id < 500; id++){
+    float x = (float) ((id*7919) % 1000)/10 - 50;
+    float y = (float) ((id*104729) % 1000)/10 - 50;
+    fleet_poses.updatePose(id, {x, y, 0});
+    expected.push_back({(x - center[0])*(x - center[0]) +
+      (y - center[1])*(y - center[1]), id});
+  }
+  std::sort(expected.begin(), expected.end());
+
+  LONGS_EQUAL(10, fleet_poses.kNearest(center, 10, cartIds));
+  for (int i = 0; i < 10; i++){
+    LONGS_EQUAL(expected[i].second, cartIds[i]);
+  }
+  LONGS_EQUAL(500, fleet_poses.kNearest(center, 1000, cartIds));
+  LONGS_EQUAL(expected[499].second, cartIds[499]);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fleet_tests, queriesRejectNonFiniteAndHugeBoxes){
+  float nan = std::numeric_limits<float>::quiet_NaN();
+  float inf = std::numeric_limits<float>::infinity();
+
+  fleet_poses.updatePose(1, {0.5, 0.5, 0});
+  fleet_poses.updatePose(2, {1e30, -1e30, 0});
+  CHECK(!fleet_poses.updatePose(3, {nan, 0, 0}));
+  CHECK(!fleet_poses.updatePose(1, {0, inf, 0}));
+  LONGS_EQUAL(2, fleet_poses.size());
+
+  //a box far bigger than the grid scans the two occupied cells only
+  LONGS_EQUAL(2, fleet_poses.zoneQuery({-1e38, -1e38}, {1e38, 1e38}, cartIds));
+  LONGS_EQUAL(1, fleet_poses.radiusQuery({0, 0}, 1e10, cartIds));
+  LONGS_EQUAL(1, cartIds[0]);
+  LONGS_EQUAL(0, fleet_poses.zoneQuery({-inf, -inf}, {inf, inf}, cartIds));
+  LONGS_EQUAL(0, fleet_poses.radiusQuery({nan, 0}, 1, cartIds));
+  LONGS_EQUAL(0, fleet_poses.radiusQuery({0, 0}, nan, cartIds));
+  LONGS_EQUAL(0, fleet_poses.kNearest({0, nan}, 1, cartIds));
+  LONGS_EQUAL(1, fleet_poses.kNearest({0, 0}, 1, cartIds));
+  LONGS_EQUAL(1, cartIds[0]);
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////checkpoint test functions////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(checkpoint_tests, emptyFileHasNoCheckpoint){
+  robotState state;
+
+  LONGS_EQUAL(1, checkpoint.openFile(path));
+  LONGS_EQUAL(-1, checkpoint.readLatest(state));
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(checkpoint_tests, restoreLatestAfterReopen){
+  robotState state = {{1.5, -2, 0.25}, 1200, 1100};
+
+  LONGS_EQUAL(1, checkpoint.openFile(path));
+  LONGS_EQUAL(1, checkpoint.writeState(state));
+  state.coords = {3, 4, 0.5};
+  state.lastAngleUpdateMS = 1300;
+  LONGS_EQUAL(1, checkpoint.writeState(state));
+
+  poseCheckpoint restarted;
+  LONGS_EQUAL(1, restarted.openFile(path));
+  LONGS_EQUAL(1, restarted.readLatest(state));
+  robot_position.restoreState(state);
+
+  DOUBLES_EQUAL(3, poseOf(robot_position)[0], 0.000001);
+  DOUBLES_EQUAL(4, poseOf(robot_position)[1], 0.000001);
+  DOUBLES_EQUAL(0.5, poseOf(robot_position)[2], 0.000001);
+  LONGS_EQUAL(1300, robot_position.lastAngleUpdateMS);
+  LONGS_EQUAL(1100, robot_position.lastXYUpdateMS);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(checkpoint_tests, tornWriteFallsBackToPrevious){
+  robotState state = {{1, 2, 3}, 10, 20};
+
+  LONGS_EQUAL(1, checkpoint.openFile(path));
+  LONGS_EQUAL(1, checkpoint.writeState(state));
+  state.coords = {7, 8, 9};
+  LONGS_EQUAL(1, checkpoint.writeState(state));
+
+  //corrupt the coordinates of the latest record, the second one in slot 0
+  int fd = open(path, O_WRONLY);
+  float garbage = 42;
+  CHECK(pwrite(fd, &garbage, sizeof(garbage),
+    offsetof(poseCheckpoint::checkpointRecord, state)) == (ssize_t) sizeof(garbage));
+  close(fd);
+
+  LONGS_EQUAL(1, checkpoint.readLatest(state));
+  DOUBLES_EQUAL(1, state.coords[0], 0.000001);
+  DOUBLES_EQUAL(2, state.coords[1], 0.000001);
+  DOUBLES_EQUAL(3, state.coords[2], 0.000001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(checkpoint_tests, loopStopsWithLastCheckpoint){
+  robotState state = {{5, 6, 0.75}, 500, 400};
+
+  LONGS_EQUAL(1, checkpoint.openFile(path));
+  robot_position.restoreState(state);
+  std::thread loop(&poseCheckpoint::checkpointLoop, &checkpoint,
+    std::ref(robot_position), 10000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  //through the locked public path, the loop saves the state meanwhile
+  std::vector<gyroSample> gyroSamples = {{1, 600}};
+  robot_position.integrate(gyroSamples, {});
+
+  //the stop cuts the period short and the final pose is saved
+  checkpoint.stopLoop();
+  loop.join();
+  LONGS_EQUAL(0, checkpoint.getWriteFailures());
+  LONGS_EQUAL(1, checkpoint.readLatest(state));
+  DOUBLES_EQUAL(0.85, state.coords[2], 0.000001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(checkpoint_tests, loopCountsWriteFailures){
+  //no file is open, every write fails
+  std::thread loop(&poseCheckpoint::checkpointLoop, &checkpoint,
+    std::ref(robot_position), 5);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  checkpoint.stopLoop();
+  loop.join();
+  CHECK(checkpoint.getWriteFailures() >= 2);
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////smoother test functions/////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(smoother_tests, noFixMatchesIntegration){
+  poseSmoother pose_smoother(50, {1, 2, 0.5});
+  std::array<float, COORDS_SIZE> pose;
+  double x = 1, y = 2, tetha = 0.5;
+
+  for (int i = 0; i < 120; i++){
+    pose_smoother.addSample(0.01, 0.002);
+    pose_smoother.solve();
+    x += 0.01*cos(tetha + 0.001);
+    y += 0.01*sin(tetha + 0.001);
+    tetha += 0.002;
+  }
+
+  LONGS_EQUAL(50, pose_smoother.size());
+  LONGS_EQUAL(1, pose_smoother.getPose(0, pose));
+  DOUBLES_EQUAL(x, pose[0], 0.0001);
+  DOUBLES_EQUAL(y, pose[1], 0.0001);
+  DOUBLES_EQUAL(tetha, pose[2], 0.0001);
+  LONGS_EQUAL(-1, pose_smoother.getPose(50, pose));
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(smoother_tests, factorizationKeptOnlyWithoutFixes){
+  poseSmoother pose_smoother(20);
+
+  for (int i = 0; i < 25; i++){
+    pose_smoother.addSample(0.01, 0);
+    pose_smoother.solve();
+  }
+  uint64_t factorizations = pose_smoother.factorizations();
+  for (int i = 0; i < 25; i++){
+    pose_smoother.addSample(0.01, 0);
+    pose_smoother.solve();
+  }
+  LONGS_EQUAL(factorizations, pose_smoother.factorizations());
+
+  pose_smoother.addFix({0.5, 0, 0});
+  pose_smoother.solve();
+  LONGS_EQUAL(factorizations + 1, pose_smoother.factorizations());
+
+  //every slide refactorizes until the fix has left the window
+  for (int i = 0; i < 20; i++){
+    pose_smoother.addSample(0.01, 0);
+    pose_smoother.solve();
+  }
+  LONGS_EQUAL(factorizations + 21, pose_smoother.factorizations());
+  pose_smoother.addSample(0.01, 0);
+  pose_smoother.solve();
+  LONGS_EQUAL(factorizations + 21, pose_smoother.factorizations());
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(smoother_tests, fixesCorrectGyroBias){
+  poseSmoother pose_smoother(200);
+  robotPosition robot_position;
+  std::array<float, COORDS_SIZE> pose;
+  pose_smoother.setNoise(0.002, 0.001, 0.01, 0.005);
+
+  //the robot drives straight along x but the gyrometer has a bias
+  for (int i = 1; i <= 400; i++){
+    pose_smoother.addSample(0.01, 0.0005);
+    robot_position.updateCoords({0.01, 0.01, 0.01, 0.01}, 10, 0.05, 10);
+    if (i % 50 == 0){
+      pose_smoother.addFix({(float) (i*0.01), 0, 0});
+    }
+    pose_smoother.solve();
+  }
+
+  //the forward integration drifted, the smoothed poses did not
+  CHECK(fabs(poseOf(robot_position)[1]) > 0.3);
+  LONGS_EQUAL(1, pose_smoother.getPose(125, pose));
+  DOUBLES_EQUAL(2.75, pose[0], 0.02);
+  DOUBLES_EQUAL(0, pose[1], 0.02);
+  DOUBLES_EQUAL(0, pose[2], 0.02);
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////compression test functions///////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(compression_tests, straightLineKeepsEnds){
+  trajectoryEncoder encoder(0.01, 0.01, 1000);
+  std::array<float, COORDS_SIZE> pose;
+
+  for (uint32_t i = 0; i < 200; i++){
+    encoder.addPose(1000 + i*10, {(float) (i*0.015), 1, 0.3});
+  }
+  encoder.flush();
+  const std::vector<uint8_t> &bytes = encoder.getBytes();
+
+  LONGS_EQUAL(2, encoder.keyPoses());
+  LONGS_EQUAL(1, decoder.decode(bytes.data(), bytes.size(), keyPoints));
+  LONGS_EQUAL(2, keyPoints.size());
+  LONGS_EQUAL(1000, keyPoints[0].timestampMS);
+  LONGS_EQUAL(2990, keyPoints[1].timestampMS);
+  LONGS_EQUAL(1, decoder.getPose(keyPoints, 1505, pose));
+  DOUBLES_EQUAL(0.7575, pose[0], 0.01);
+  DOUBLES_EQUAL(1, pose[1], 0.01);
+  DOUBLES_EQUAL(0.3, pose[2], 0.01);
+  LONGS_EQUAL(-1, decoder.getPose(keyPoints, 3000, pose));
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(compression_tests, circleWithinErrorBounds){
+  trajectoryEncoder encoder(0.02, 0.01);
+  std::vector<trajectoryPoint> poses;
+  std::array<float, COORDS_SIZE> pose;
+
+  //two turns of a 2m radius circle at 1m/s, sampled at 100Hz
+  for (uint32_t i = 0; i < 2500; i++){
+    float angle = i*0.005;
+    poses.push_back({i*10, {(float) (2*sin(angle)), (float) (2 - 2*cos(angle)),
+      (float) fmod(angle, 2*PI)}});
+    encoder.addPose(poses.back().timestampMS, poses.back().pose);
+  }
+  encoder.flush();
+  const std::vector<uint8_t> &bytes = encoder.getBytes();
+
+  CHECK(encoder.keyPoses()*10 < encoder.poses());
+  CHECK(bytes.size()*10 < poses.size()*sizeof(trajectoryPoint));
+  LONGS_EQUAL(1, decoder.decode(bytes.data(), bytes.size(), keyPoints));
+  LONGS_EQUAL(encoder.keyPoses(), keyPoints.size());
+  for (const trajectoryPoint &point : poses){
+    LONGS_EQUAL(1, decoder.getPose(keyPoints, point.timestampMS, pose));
+    CHECK(hypot(pose[0] - point.pose[0], pose[1] - point.pose[1]) <= 0.02001);
+    CHECK(fabs(remainder(pose[2] - point.pose[2], 2*PI)) <= 0.01001);
+  }
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(compression_tests, truncatedStreamRejected){
+  trajectoryEncoder encoder(0.01, 0.01);
+
+  encoder.addPose(0, {0, 0, 0});
+  encoder.addPose(10, {1000, -1000, 3});
+  encoder.flush();
+  const std::vector<uint8_t> &bytes = encoder.getBytes();
+
+  LONGS_EQUAL(1, decoder.decode(bytes.data(), bytes.size(), keyPoints));
+  DOUBLES_EQUAL(1000, keyPoints[1].pose[0], 0.01);
+  DOUBLES_EQUAL(-1000, keyPoints[1].pose[1], 0.01);
+  LONGS_EQUAL(-1, decoder.decode(bytes.data(), bytes.size() - 1, keyPoints));
+  LONGS_EQUAL(-1, decoder.decode(bytes.data(), 3, keyPoints));
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(compression_tests, sinkCompressesRobotOutput){
+  trajectoryEncoder encoder(0.01, 0.01);
+  robotPosition robot_position;
+  std::vector<gyroSample> gyroSamples;
+  std::vector<odometrySample> odometrySamples;
+
+  //a straight line then a turn, 10 seconds at 10Hz
+  for (uint32_t i = 0; i <= 100; i++){
+    float dist = i == 0 ? 0 : 0.1;
+    gyroSamples.push_back({i < 50 ? 0.0f : 0.5f, i*100});
+    odometrySamples.push_back({{dist, dist, dist, dist}, i*100});
+  }
+  robot_position.setPoseSink(trajectoryEncoder::sink, &encoder);
+  robot_position.integrate(gyroSamples, odometrySamples);
+  encoder.flush();
+
+  //every x and y update reached the encoder, the last pose is kept
+  LONGS_EQUAL(101, encoder.poses());
+  CHECK(encoder.keyPoses() < 101);
+  LONGS_EQUAL(1, decoder.decode(encoder.getBytes().data(),
+    encoder.getBytes().size(), keyPoints));
+  LONGS_EQUAL(10000, keyPoints.back().timestampMS);
+  DOUBLES_EQUAL(poseOf(robot_position)[0], keyPoints.back().pose[0], 0.01);
+  DOUBLES_EQUAL(poseOf(robot_position)[1], keyPoints.back().pose[1], 0.01);
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////adaptive rate test functions//////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(adaptive_rate_tests, fixedRateByDefault){
+  for (int i = 0; i < 100; i++){
+    robot_position.updateMotion(true);
+  }
+
+  LONGS_EQUAL(10, robot_position.loopPeriodMS(100));
+  robot_position.getRateStats(stats);
+  CHECK(!stats.idle);
+  LONGS_EQUAL(0, stats.toIdle);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(adaptive_rate_tests, idleAfterStillSamples){
+  robot_position.setAdaptiveRate(2, 0.005, 0.005, 3);
+
+  robot_position.updateMotion(true);
+  robot_position.updateMotion(true);
+  LONGS_EQUAL(10, robot_position.loopPeriodMS(100));
+  robot_position.updateMotion(true);
+  LONGS_EQUAL(500, robot_position.loopPeriodMS(100));
+  LONGS_EQUAL(500, robot_position.loopPeriodMS(50));
+
+  robot_position.updateMotion(false);
+  LONGS_EQUAL(10, robot_position.loopPeriodMS(100));
+  LONGS_EQUAL(20, robot_position.loopPeriodMS(50));
+  robot_position.getRateStats(stats);
+  CHECK(!stats.idle);
+  LONGS_EQUAL(1, stats.toIdle);
+  LONGS_EQUAL(1, stats.toActive);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(adaptive_rate_tests, motionCutsIdleSleep){
+  robot_position.setAdaptiveRate(2, 0.005, 0.005, 1);
+  robot_position.updateMotion(true);
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread sleeper(&robotPosition::waitPeriod, &robot_position, 2000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  robot_position.updateMotion(false);
+  sleeper.join();
+
+  CHECK(std::chrono::steady_clock::now() - start <
+    std::chrono::milliseconds(500));
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(adaptive_rate_tests, parkedLoopsSlowDown){
+  robot_position.setAdaptiveRate(5, 0.005, 0.005, 4);
+
+  //the mockup acquisitions show a parked robot
+  std::thread loops(&robotPosition::updateCoordsThreads, &robot_position,
+    100, 100);
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  robot_position.stopLoops();
+  loops.join();
+
+  robot_position.getRateStats(stats);
+  CHECK(stats.idle);
+  LONGS_EQUAL(1, stats.toIdle);
+  CHECK(stats.gyroWakeups < 10);
+  CHECK(stats.odometryWakeups < 10);
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////fixed point test functions///////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fixed_point_tests, sinCosMatchFloat){
+  for (int i = -2000; i <= 2000; i++){
+    float angle = i*0.0031;
+    binaryAngle binary = binaryAngleFromRad(angle);
+
+    DOUBLES_EQUAL(sin(angle),
+      (double) fixedSin(binary)/(1 << FIXED_SINCOS_BITS), 0.00001);
+    DOUBLES_EQUAL(cos(angle),
+      (double) fixedCos(binary)/(1 << FIXED_SINCOS_BITS), 0.00001);
+  }
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fixed_point_tests, binaryAngleWraps){
+  //three quarters of a turn forward ends a quarter of a turn backward
+  fixedUpdateAngle(pose, binaryRateFromRad(3*PI/2), 1000);
+  DOUBLES_EQUAL(-PI/2, radFromBinaryAngle(pose.tetha), 0.0001);
+
+  //many turns, the angle never saturates
+  for (int i = 0; i < 1000; i++){
+    fixedUpdateAngle(pose, binaryRateFromRad(2*PI), 1000);
+  }
+  DOUBLES_EQUAL(-PI/2, radFromBinaryAngle(pose.tetha), 0.0001);
+  DOUBLES_EQUAL(PI/4, radFromBinaryAngle(binaryAngleFromRad(PI/4 + 4*PI)),
+    0.0001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(fixed_point_tests, trajectoryMatchesFloat){
+  std::array<float, 4> odometry;
+  double x = 0, y = 0, tetha = 0;
+
+  //10 minutes of driving at 100Hz, against a double precision reference
+  for (int i = 0; i < 60000; i++){
+    float yawRate = 0.8*sin(i*0.0007);
+    float dist = 0.01 + 0.005*cos(i*0.0013);
+    odometry = {dist, dist, dist, dist};
+
+    robot_position.updateAngle(yawRate, 10);
+    robot_position.updateXY(odometry, 10);
+    fixedUpdateAngle(pose, binaryRateFromRad(yawRate), 10);
+    fixedUpdateXY(pose, fixedFromFloat(dist));
+    tetha += yawRate*0.01;
+    x += dist*cos(tetha);
+    y += dist*sin(tetha);
+  }
+
+  std::array<float, COORDS_SIZE> coords = poseOf(robot_position);
+  DOUBLES_EQUAL(x, coords[0], 0.05);
+  DOUBLES_EQUAL(y, coords[1], 0.05);
+  DOUBLES_EQUAL(0, remainder(coords[2] - tetha, 2*PI), 0.001);
+  DOUBLES_EQUAL(x, floatFromFixed(pose.x), 0.05);
+  DOUBLES_EQUAL(y, floatFromFixed(pose.y), 0.05);
+  DOUBLES_EQUAL(0, remainder(radFromBinaryAngle(pose.tetha) - tetha, 2*PI),
+    0.001);
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+/////////////////////static position test functions/////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(static_position_tests, tickMergesByTimestamp){
+  //the odometry is pushed first but the gyrometer sample is older
+  std::array<float, 4> odometry = {1, 1, 1, 1};
+  LONGS_EQUAL(1, static_position.pushOdometry(odometry, 1000));
+  LONGS_EQUAL(1, static_position.pushGyrometer(PI/2, 1000));
+  LONGS_EQUAL(1, static_position.pushOdometry(odometry, 2000));
+  LONGS_EQUAL(3, static_position.tick());
+
+  robot_position.updateAngle(PI/2, 1000);
+  robot_position.updateXY(odometry, 1000);
+  robot_position.updateXY(odometry, 1000);
+  static_position.getCoords(coords);
+  for (int i = 0; i < COORDS_SIZE; i++){
+    DOUBLES_EQUAL(poseOf(robot_position)[i], coords[i], 0.000001);
+  }
+  DOUBLES_EQUAL(2, coords[1], 0.0001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(static_position_tests, fullQueueDropsSample){
+  for (uint32_t i = 0; i < 8; i++){
+    LONGS_EQUAL(1, static_position.pushGyrometer(0.1, i*10));
+  }
+  LONGS_EQUAL(-1, static_position.pushGyrometer(0.1, 80));
+  LONGS_EQUAL(1, static_position.droppedSamples());
+
+  //a bounded tick leaves the rest for the next one
+  LONGS_EQUAL(3, static_position.tick(3));
+  LONGS_EQUAL(1, static_position.pushGyrometer(0.1, 80));
+  LONGS_EQUAL(6, static_position.tick());
+  LONGS_EQUAL(0, static_position.tick());
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(static_position_tests, noAllocationInSteadyState){
+  std::array<float, 4> odometry = {0.01, 0.012, 0.01, 0.012};
+
+  countAllocations = true;
+  for (uint32_t i = 1; i <= 10000; i++){
+    robot_position.updateAngle(0.2, 10);
+    robot_position.updateXY(odometry, 10);
+    static_position.pushGyrometer(0.2, i*10);
+    static_position.pushOdometry(odometry, i*10);
+    static_position.tick();
+  }
+  countAllocations = false;
+
+  LONGS_EQUAL(0, allocations);
+  LONGS_EQUAL(0, static_position.droppedSamples());
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////batch test functions//////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(batch_tests, batchMatchesPerSample){
+  size_t odometryIndex = 0;
+
+  //the per-sample calls in timestamp order, as the loops would do
+  for (size_t i = 0; i <= gyroSamples.size(); i++){
+    uint32_t timestamp = i < gyroSamples.size() ?
+      gyroSamples[i].timestampMS : UINT32_MAX;
+    while (odometryIndex < odometrySamples.size() &&
+      odometrySamples[odometryIndex].timestampMS < timestamp){
+
+      const odometrySample &odometry = odometrySamples[odometryIndex++];
+      robot_position.updateXY(odometry.odometry,
+        odometry.timestampMS - robot_position.lastXYUpdateMS);
+      robot_position.lastXYUpdateMS = odometry.timestampMS;
+    }
+    if (i < gyroSamples.size()){
+      robot_position.updateAngle(gyroSamples[i].yawRate,
+        timestamp - robot_position.lastAngleUpdateMS);
+      robot_position.lastAngleUpdateMS = timestamp;
+    }
+  }
+
+  LONGS_EQUAL(0, batch_position.integrate(gyroSamples, odometrySamples));
+
+  for (int i = 0; i < COORDS_SIZE; i++){
+    DOUBLES_EQUAL(poseOf(robot_position)[i], poseOf(batch_position)[i],
+      0.000001);
+  }
+  LONGS_EQUAL(20000, batch_position.lastAngleUpdateMS);
+  LONGS_EQUAL(20003, batch_position.lastXYUpdateMS);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(batch_tests, batchWritesPoses){
+  std::vector<trajectoryPoint> poses(3000);
+
+  //one pose per sample, in timestamp order
+  LONGS_EQUAL(3000, batch_position.integrate(gyroSamples, odometrySamples,
+    poses));
+  for (size_t i = 1; i < poses.size(); i++){
+    CHECK(poses[i - 1].timestampMS <= poses[i].timestampMS);
+  }
+  for (int i = 0; i < COORDS_SIZE; i++){
+    DOUBLES_EQUAL(poseOf(batch_position)[i], poses.back().pose[i], 0.000001);
+  }
+
+  //a short buffer only gets the first poses, the pose goes to the end
+  std::array<trajectoryPoint, 2> firstPoses;
+  LONGS_EQUAL(2, robot_position.integrate(gyroSamples, odometrySamples,
+    firstPoses));
+  LONGS_EQUAL(10, firstPoses[0].timestampMS);
+  LONGS_EQUAL(20, firstPoses[1].timestampMS);
+  for (int i = 0; i < COORDS_SIZE; i++){
+    DOUBLES_EQUAL(poseOf(batch_position)[i], poseOf(robot_position)[i],
+      0.000001);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////integration test functions///////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(integration_tests, unknownSchemeRejected){
+  LONGS_EQUAL(-1, robot_position.setIntegration(-1));
+  LONGS_EQUAL(-1, robot_position.setIntegration(INTEGRATION_RK4 + 1));
+  LONGS_EQUAL(1, robot_position.setIntegration(INTEGRATION_EULER));
+#ifdef FIXED_POINT_POSITION
+  LONGS_EQUAL(-1, robot_position.setIntegration(INTEGRATION_ARC));
+#endif
+}
+
+#ifndef FIXED_POINT_POSITION
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(integration_tests, eulerDriftsOnCircle){
+  //at 5Hz the straight steps cut the circle
+  CHECK(circleError(INTEGRATION_EULER, 200) > 0.1);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(integration_tests, arcExactOnCircle){
+  DOUBLES_EQUAL(0, circleError(INTEGRATION_ARC, 200), 0.001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(integration_tests, midpointAndRK4OnCircle){
+  DOUBLES_EQUAL(0, circleError(INTEGRATION_MIDPOINT, 200), 0.02);
+  gyroSamples.clear();
+  odometrySamples.clear();
+  robot_position.coords = {0, 0, 0};
+  robot_position.lastAngleUpdateMS = 0;
+  robot_position.lastXYUpdateMS = 0;
+  DOUBLES_EQUAL(0, circleError(INTEGRATION_RK4, 200), 0.02);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(integration_tests, updateXYFollowsScheme){
+  std::array<float, 4> odometry = {0.2, 0.2, 0.2, 0.2};
+  //the first yaw rate, the interpolation starts from it
+  robot_position.updateAngle(0.5, 0);
+  robot_position.setIntegration(INTEGRATION_ARC);
+
+  //the per-sample updates move along the same arc as integrate
+  for (int i = 0; i < 100; i++){
+    robot_position.updateAngle(0.5, 200);
+    robot_position.updateXY(odometry, 200);
+  }
+  DOUBLES_EQUAL(sin(0.5*20)/0.5, poseOf(robot_position)[0], 0.001);
+  DOUBLES_EQUAL((1 - cos(0.5*20))/0.5, poseOf(robot_position)[1], 0.001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(integration_tests, firstYawRateSeeded){
+  robotState state;
+  robot_position.setIntegration(INTEGRATION_MIDPOINT);
+
+  //the first sample is not averaged with a yaw rate of 0
+  robot_position.updateAngle(1, 500);
+  DOUBLES_EQUAL(0.5, poseOf(robot_position)[2], 0.000001);
+  robot_position.updateAngle(0, 500);
+  DOUBLES_EQUAL(0.75, poseOf(robot_position)[2], 0.000001);
+
+  //nor after a restart with a yaw rate of 0 before it
+  robot_position.saveState(state);
+  robot_position.restoreState(state);
+  robot_position.updateAngle(1, 500);
+  DOUBLES_EQUAL(1.25, poseOf(robot_position)[2], 0.000001);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////calibration test functions///////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(calibration_tests, stillSamplesIgnored){
+  LONGS_EQUAL(-1, calibrator.addSample(0, 0, 0.01));
+  LONGS_EQUAL(0, calibrator.samples());
+  calibrator.getScales(leftScale, rightScale);
+  DOUBLES_EQUAL(1, leftScale, 0.000001);
+  DOUBLES_EQUAL(1, rightScale, 0.000001);
+  DOUBLES_EQUAL(TRACK_WIDTH, calibrator.getEffectiveTrackWidth(), 0.000001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(calibration_tests, exactSamplesConverge){
+  //a worn left wheel reads 3% too far, the right one 1% too short
+  for (int i = 0; i < 2000; i++){
+    float left = 0.01 - 0.004*sin(i*0.05);
+    float right = 0.01 + 0.004*sin(i*0.05);
+    calibrator.addSample(left/0.97, right/1.01,
+      (right - left)/TRACK_WIDTH);
+  }
+
+  calibrator.getScales(leftScale, rightScale);
+  DOUBLES_EQUAL(0.97, leftScale, 0.001);
+  DOUBLES_EQUAL(1.01, rightScale, 0.001);
+  DOUBLES_EQUAL(TRACK_WIDTH*2/(0.97 + 1.01),
+    calibrator.getEffectiveTrackWidth(), 0.001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(calibration_tests, replayWithMisScaledWheels){
+  //10 minutes at 50Hz and 1m/s with a varying turn, the true distance is
+  //0.97 times the left reading and 1.02 times the right one
+  double x = 0;
+  double y = 0;
+  double tetha = 0;
+  calibrated_position.setSelfCalibration(true);
+
+  for (int i = 1; i <= 30000; i++){
+    double t = i*0.02;
+    double yawRate = 0.6*sin(0.2*t) + 0.3*sin(0.05*t);
+    double left = (1 - yawRate*TRACK_WIDTH/2)*0.02;
+    double right = (1 + yawRate*TRACK_WIDTH/2)*0.02;
+    std::array<float, 4> odometry = {(float) (left/0.97),
+      (float) (right/1.02), (float) (left/0.97), (float) (right/1.02)};
+
+    calibrated_position.updateAngle(yawRate, 20);
+    calibrated_position.updateXY(odometry, 20);
+    raw_position.updateAngle(yawRate, 20);
+    raw_position.updateXY(odometry, 20);
+    tetha += yawRate*0.02;
+    x += (left + right)/2*cos(tetha);
+    y += (left + right)/2*sin(tetha);
+  }
+
+  calibrated_position.getCalibration(leftScale, rightScale, trackWidth);
+  DOUBLES_EQUAL(0.97, leftScale, 0.002);
+  DOUBLES_EQUAL(1.02, rightScale, 0.002);
+  DOUBLES_EQUAL(TRACK_WIDTH*2/(0.97 + 1.02), trackWidth, 0.002);
+
+  //most of the drift of the raw wheels is gone
+  double calibratedError = hypot(poseOf(calibrated_position)[0] - x,
+    poseOf(calibrated_position)[1] - y);
+  double rawError = hypot(poseOf(raw_position)[0] - x,
+    poseOf(raw_position)[1] - y);
+  CHECK(rawError > 0.5);
+  CHECK(calibratedError < rawError/10);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(calibration_tests, straightDrivingDoesNotWindUp){
+  calibrationState state;
+
+  //the variance of the turn direction right + left, not seen driving
+  //straight
+  auto turnVariance = [&](){
+    calibrator.getState(state);
+    double det = state.iRR*state.iLL - state.iRL*state.iRL;
+    return (state.iRR + 2*state.iRL + state.iLL)/(2*det);
+  };
+
+  for (int i = 0; i < 2000; i++){
+    float left = 0.01 - 0.004*sin(i*0.05);
+    float right = 0.01 + 0.004*sin(i*0.05);
+    calibrator.addSample(left, right, (right - left)/TRACK_WIDTH);
+  }
+  double before = turnVariance();
+
+  //ten times the memory of the forgetting factor in a straight line
+  for (int i = 0; i < 200000; i++){
+    calibrator.addSample(0.01, 0.01, 0);
+  }
+  CHECK(turnVariance() <= before*1.001);
+  calibrator.getScales(leftScale, rightScale);
+  DOUBLES_EQUAL(1, leftScale, 0.001);
+  DOUBLES_EQUAL(1, rightScale, 0.001);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(calibration_tests, calibrationSurvivesRestart){
+  robotState state;
+  float restartedLeft;
+  float restartedRight;
+  float restartedWidth;
+  calibrated_position.setSelfCalibration(true);
+
+  for (int i = 1; i <= 3000; i++){
+    double yawRate = 0.6*sin(0.004*i);
+    float left = (1 - yawRate*TRACK_WIDTH/2)*0.02;
+    float right = (1 + yawRate*TRACK_WIDTH/2)*0.02;
+    std::array<float, 4> odometry = {left/0.97f, right/1.02f, left, right};
+    calibrated_position.updateAngle(yawRate, 20);
+    calibrated_position.updateXY(odometry, 20);
+  }
+
+  //raw_position restarts from the checkpoint of calibrated_position
+  calibrated_position.saveState(state);
+  raw_position.restoreState(state);
+  calibrated_position.getCalibration(leftScale, rightScale, trackWidth);
+  raw_position.getCalibration(restartedLeft, restartedRight,
+    restartedWidth);
+  CHECK(fabs(leftScale - 1) > 0.01);
+  DOUBLES_EQUAL(leftScale, restartedLeft, 0.000001);
+  DOUBLES_EQUAL(rightScale, restartedRight, 0.000001);
+  DOUBLES_EQUAL(trackWidth, restartedWidth, 0.000001);
+
+  //and keeps learning the same way
+  std::array<float, 4> odometry = {0.02, 0.021, 0.02, 0.021};
+  for (robotPosition *position : {&calibrated_position, &raw_position}){
+    position->updateAngle(0.1, 20);
+    position->updateXY(odometry, 20);
+  }
+  calibrated_position.getCalibration(leftScale, rightScale, trackWidth);
+  raw_position.getCalibration(restartedLeft, restartedRight,
+    restartedWidth);
+  DOUBLES_EQUAL(leftScale, restartedLeft, 0.000001);
+  DOUBLES_EQUAL(rightScale, restartedRight, 0.000001);
+  LONGS_EQUAL(calibrated_position.calibrator.samples(),
+    raw_position.calibrator.samples());
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////event loop test functions////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(event_loop_tests, timersResumeInDeadlineOrder){
+  loop.spawn(sleeper(0, 30));
+  loop.spawn(sleeper(1, 10));
+  loop.spawn(sleeper(2, 20));
+
+  LONGS_EQUAL(1, loop.run());
+  LONGS_EQUAL(3, order.size());
+  LONGS_EQUAL(1, order[0]);
+  LONGS_EQUAL(2, order[1]);
+  LONGS_EQUAL(0, order[2]);
+  loop.getStats(stats);
+  LONGS_EQUAL(3, stats.timerWakeups);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(event_loop_tests, readableResumesOnData){
+  int fds[2];
+  char value = 0;
+  char invalid = 0;
+  CHECK(pipe(fds) == 0);
+
+  loop.spawn(reader(fds[0], value));
+  loop.spawn(writer(fds[1], 'a'));
+  //a file descriptor epoll refuses does not suspend the task
+  loop.spawn(reader(-1, invalid));
+
+  LONGS_EQUAL(1, loop.run());
+  LONGS_EQUAL('a', value);
+  LONGS_EQUAL(0, invalid);
+  loop.getStats(stats);
+  LONGS_EQUAL(1, stats.fdWakeups);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(event_loop_tests, manySourcesOnOneThread){
+  for (int i = 0; i < 200; i++){
+    loop.spawn(periodic(std::this_thread::get_id(), 5));
+  }
+
+  LONGS_EQUAL(1, loop.run());
+  LONGS_EQUAL(1000, resumes);
+  LONGS_EQUAL(0, foreignResumes);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(event_loop_tests, robotTasksKeepTheirRates){
+  robotPosition robot_position;
+  rateStats rates;
+
+  robot_position.updateCoordsTasks(loop, 200, 100);
+  std::thread stopper([&robot_position]{
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    robot_position.stopLoops();
+  });
+  LONGS_EQUAL(1, loop.run());
+  stopper.join();
+
+  //about 40 and 20 periods, the deadlines do not drift with the work
+  robot_position.getRateStats(rates);
+  CHECK(rates.gyroWakeups >= 30 && rates.gyroWakeups <= 43);
+  CHECK(rates.odometryWakeups >= 15 && rates.odometryWakeups <= 23);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+TEST(event_loop_tests, stopLoopsWakesParkedTasks){
+  robotPosition robot_position;
+
+  //at 1Hz the tasks are parked in the timers for a whole second
+  robot_position.updateCoordsTasks(loop, 1, 1);
+  std::thread stopper([&robot_position]{
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    robot_position.stopLoops();
+  });
+  uint64_t start = eventLoop::nowNs();
+  LONGS_EQUAL(1, loop.run());
+  stopper.join();
+  CHECK(eventLoop::nowNs() - start < 500000000);
+
+  //the stop only ended that run, the loop runs the next tasks
+  loop.spawn(sleeper(7, 1));
+  LONGS_EQUAL(1, loop.run());
+  LONGS_EQUAL(1, order.size());
+  LONGS_EQUAL(7, order[0]);
+}
+
 int main(int ac, char** av)
 {
     return CommandLineTestRunner::RunAllTests(ac, av);
@@ -0,0 +1,213 @@
+/**
+ * @Author: Kristian Harge
+ * @Date:   2026-10-19T17:48:05+02:00
+ * @Email:  kristian.harge@yahoo.com
+ * @Filename: tests_c.c
+ * @Last modified time: 2026-10-19T17:48:05+02:00
+ */
+
+//the tests of the C interface, built as C to check that the header is
+//usable from it
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dead_reckoning_c.h"
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////macros//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//a macro to check a condition and count the failures, a failed test
+//jumps to its end label which frees its handles
+#define CHECK(condition)        if (!(condition)){ \
+                                  printf("%s:%d: FAIL %s\n", __FILE__, \
+                                    __LINE__, #condition); \
+                                  failures++; \
+                                  goto end; \
+                                }
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+//////////////////////////////constants/////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the number of samples of each sensor, 20 seconds at 5Hz
+#define SAMPLES                    101
+//the period of the samples in miliseconds
+#define PERIOD_MS                  200
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+///////////////////////////////helpers//////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//the number of failed tests
+static int failures = 0;
+
+//the samples of a circle at 1m/s and 0.5rad/s
+static deadReckoningGyroSample gyroSamples[SAMPLES];
+static deadReckoningOdometrySample odometrySamples[SAMPLES];
+
+//~ Function: fillCircle
+//~ ----------------------------
+//~ Fills the samples of the circle
+//~
+//~ output: void
+static void fillCircle(void){
+  for (int i = 0; i < SAMPLES; i++){
+    float dist = i == 0 ? 0 : PERIOD_MS/1000.0;
+    gyroSamples[i].yawRate = 0.5;
+    gyroSamples[i].timestampMS = i*PERIOD_MS;
+    for (int j = 0; j < 4; j++){
+      odometrySamples[i].odometry[j] = dist;
+    }
+    odometrySamples[i].timestampMS = i*PERIOD_MS;
+  }
+}// end function fillCircle
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+/////////////////////////////test functions/////////////////////////////
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+static void createStartsAtOrigin(void){
+  float pose[3] = {1, 1, 1};
+  deadReckoning *position = deadReckoningCreate();
+
+  CHECK(position != NULL);
+  CHECK(deadReckoningGetPose(position, pose) == 1);
+  CHECK(pose[0] == 0 && pose[1] == 0 && pose[2] == 0);
+  deadReckoningDestroy(NULL);
+end:
+  deadReckoningDestroy(position);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+static void integrateWritesPoses(void){
+  static deadReckoningPose poses[2*SAMPLES];
+  float pose[3];
+  deadReckoning *position = deadReckoningCreate();
+
+  CHECK(deadReckoningSetIntegration(position, INTEGRATION_ARC) == 1);
+  CHECK(deadReckoningIntegrate(position, gyroSamples, SAMPLES,
+    odometrySamples, SAMPLES, poses, 2*SAMPLES) == 2*SAMPLES);
+  CHECK(deadReckoningGetPose(position, pose) == 1);
+
+  //the arc follows the circle, the last pose written is the final one
+  CHECK(fabs(pose[0] - sin(0.5*20)/0.5) < 0.001);
+  CHECK(fabs(pose[1] - (1 - cos(0.5*20))/0.5) < 0.001);
+  CHECK(poses[2*SAMPLES - 1].timestampMS == (SAMPLES - 1)*PERIOD_MS);
+  CHECK(poses[2*SAMPLES - 1].pose[0] == pose[0]);
+  CHECK(poses[2*SAMPLES - 1].pose[1] == pose[1]);
+end:
+  deadReckoningDestroy(position);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+static void shortOrNoPoseBuffer(void){
+  deadReckoningPose poses[3];
+  float pose[3];
+  float withoutPoses[3];
+  deadReckoning *position = deadReckoningCreate();
+  deadReckoning *other = deadReckoningCreate();
+
+  CHECK(deadReckoningIntegrate(position, gyroSamples, SAMPLES,
+    odometrySamples, SAMPLES, poses, 3) == 3);
+  CHECK(deadReckoningIntegrate(other, gyroSamples, SAMPLES,
+    odometrySamples, SAMPLES, NULL, 0) == 0);
+  deadReckoningGetPose(position, pose);
+  deadReckoningGetPose(other, withoutPoses);
+  CHECK(pose[0] == withoutPoses[0] && pose[1] == withoutPoses[1]);
+end:
+  deadReckoningDestroy(position);
+  deadReckoningDestroy(other);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+static void setPoseStartsReplay(void){
+  float start[3] = {10, -5, 1.5};
+  float pose[3];
+  deadReckoning *position = deadReckoningCreate();
+
+  //only the samples after the pose move the robot
+  CHECK(deadReckoningSetPose(position, start, 4000) == 1);
+  CHECK(deadReckoningIntegrate(position, gyroSamples + 21, 1,
+    odometrySamples + 21, 1, NULL, 0) == 0);
+  deadReckoningGetPose(position, pose);
+  CHECK(fabs(pose[2] - 1.6) < 0.0001);
+  CHECK(fabs(pose[0] - (10 + 0.2*cos(1.6))) < 0.0001);
+  CHECK(fabs(pose[1] - (-5 + 0.2*sin(1.6))) < 0.0001);
+end:
+  deadReckoningDestroy(position);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+static void nullPointersRejected(void){
+  deadReckoning *position = deadReckoningCreate();
+
+  CHECK(deadReckoningIntegrate(NULL, gyroSamples, SAMPLES, NULL, 0,
+    NULL, 0) == -1);
+  CHECK(deadReckoningIntegrate(position, NULL, 1, NULL, 0, NULL, 0) == -1);
+  CHECK(deadReckoningIntegrate(position, NULL, 0, NULL, 0, NULL, 5) == -1);
+  CHECK(deadReckoningIntegrate(position, NULL, 0, NULL, 0, NULL, 0) == 0);
+  CHECK(deadReckoningGetPose(position, NULL) == -1);
+  CHECK(deadReckoningSetIntegration(position, 42) == -1);
+end:
+  deadReckoningDestroy(position);
+}
+
+//~ Test :
+//~ ----------------------------
+//~
+//~
+static void posesInTimestampOrder(void){
+  static deadReckoningPose poses[2*SAMPLES];
+  deadReckoning *position = deadReckoningCreate();
+
+  //the poses follow the merge of the two arrays, a gyrometer then an odometry
+  CHECK(deadReckoningIntegrate(position, gyroSamples, SAMPLES,
+    odometrySamples, SAMPLES, poses, 2*SAMPLES) == 2*SAMPLES);
+  for (int i = 0; i < 2*SAMPLES; i++){
+    CHECK(poses[i].timestampMS == (uint32_t) (i/2*PERIOD_MS));
+  }
+end:
+  deadReckoningDestroy(position);
+}
+
+int main(void){
+  void (*tests[])(void) = {createStartsAtOrigin, integrateWritesPoses,
+    shortOrNoPoseBuffer, setPoseStartsReplay, nullPointersRejected,
+    posesInTimestampOrder};
+  int count = sizeof(tests)/sizeof(tests[0]);
+
+  fillCircle();
+  for (int i = 0; i < count; i++){
+    tests[i]();
+  }
+  printf("%d tests, %d failures\n", count, failures);
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}